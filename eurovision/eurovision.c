@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 #include "functions.h"
 
 /*
@@ -14,48 +15,207 @@
  * #include "state.h"
 */
 
+/** results computed for one generation of a eurovision, kept for repeated queries */
+typedef struct resultsCache_t {
+    unsigned long generation;       // the generation the results were computed for
+    PointVector audience_points;    // tally of the audience points, NULL if not computed yet
+    PointVector judge_points;       // tally of the judge points (same order), NULL if not computed yet
+    PointVector contest_ranking;    // final points of the last contest, NULL if not computed yet
+    int contest_percent;            // audience percent of contest_ranking
+    int contest_count;              // number of states sorted at the start of contest_ranking
+    PointVector audience_ranking;   // the audience points sorted, NULL if not computed yet
+    List friendly_states;           // the friendly states list, NULL if not computed yet
+} ResultsCache;
+
 struct eurovision_t {
-    Map States; // key = State ID, data = State's name, song name and votes it gives
-    Map Judges; // key = Judge ID, data = Judge's name and results
+    Map States; // key = State ID, data = State's name, song name, votes it gives and points it gets
+    JudgeMap Judges;    // key = Judge ID, data = Judge's name and results
+    FriendlyPairs Friends;  // the friendly pairs of states, updated on every change of the votes
+    TallyPool tally_pool;   // threads for tallying the audience points, NULL for the calling thread only
+    unsigned long generation;   // bumped on every change of the states, judges or votes
+    ResultsCache cache;         // results of the queries, valid only for cache.generation
+    pthread_mutex_t cache_lock; // taken by the queries, guards the cache and the friendly set's rebuild
 };
 
+/***
+ * Deallocates the results in the cache and marks them as not computed
+ * @param cache the cache to clear
+ */
+static void cacheClear(ResultsCache *cache);
+
+/***
+ * Makes sure the cache holds results of the current generation (clears it if it doesn't)
+ * @param eurovision the eurovision of the cache
+ */
+static void cacheSync(Eurovision eurovision);
+
+/***
+ * Tallies the audience and judge points into the cache, if they aren't there yet
+ * @param eurovision the eurovision of the cache (the cache must be synced)
+ * @return false if an allocation failed, true otherwise
+ */
+static bool cacheTallies(Eurovision eurovision);
+
+/***
+ * Ranks the k highest states of a contest, from the cache if it can
+ * (the cache lock must be held)
+ * @param eurovision the eurovision the states are in (with at least k states, and at least one)
+ * @param audience_percent wanted percentage of the audience points in the final calculation
+ * @param k number of states to rank
+ * @return sorted string list of the names of the k highest ranking states,
+ *   NULL if an allocation failed
+ */
+static List cachedContest(Eurovision eurovision, int audience_percent, int k);
+
+/***
+ * Ranks all the states for each of the audience percents (the cache lock must be held)
+ * @param eurovision the eurovision the states are in
+ * @param percents the audience percents
+ * @param rankings array of n NULL lists to fill with the rankings
+ * @param n number of percents
+ * @return false if an allocation failed (then the lists made so far are destroyed), true otherwise
+ */
+static bool cachedContestSweep(Eurovision eurovision, const int *percents, List *rankings, size_t n);
+
+/***
+ * Ranks the states by their audience points, from the cache if it can
+ * (the cache lock must be held)
+ * @param eurovision the eurovision the states are in
+ * @return sorted string list of the states' names, NULL if an allocation failed
+ */
+static List cachedAudienceFavorite(Eurovision eurovision);
+
+/***
+ * Lists the friendly states, from the cache if it can (the cache lock must be held)
+ * @param eurovision the eurovision the states are in (with at least one state)
+ * @return sorted string list of the friendly pairs, NULL if an allocation failed
+ */
+static List cachedFriendlyStates(Eurovision eurovision);
+
+/***
+ * Calculates the final points of each state and ranks the states accordingly
+ * @param eurovision the eurovision the states are in
+ * @param audience_points point vector of the audience points (becomes the final points,
+ *   deallocated by this function)
+ * @param judge_points point vector of the judge points (deallocated by this function)
+ * @param audience_percent wanted percentage of the audience points in the final calculation
+ * @param count number of states to rank (only they are sorted)
+ * @return sorted string list of the names of the count highest ranking states,
+ *   NULL if an allocation failed
+ */
+static List rankStates(Eurovision eurovision, PointVector audience_points,
+                       PointVector judge_points, int audience_percent, int count);
+
+/***
+ * Makes writable all the states that removing a state changes (see stateMakeWritable):
+ * the states that vote for it, the states it votes for and the states its judges ranked
+ * @param eurovision the eurovision the state is in
+ * @param removed_data the data of the state to remove
+ * @return false if an allocation failed, true otherwise
+ */
+static bool makeRemovalWritable(Eurovision eurovision, StateData removed_data);
+
+/***
+ * Deallocates an array of lists
+ * @param lists the array (NULL lists in it are skipped)
+ * @param n number of lists in the array
+ */
+static void destroyLists(List *lists, size_t n);
+
 Eurovision eurovisionCreate() {
     Eurovision eurovision = malloc(sizeof(*eurovision));    // allocate memory for the struct
     if (!eurovision) return NULL;       // allocation failed
 
     // create the States map using the appropriate functions (from state.h)
-    eurovision->States = mapCreate(copyStateDataElement,
-                                   copyStateKeyElement,
-                                   freeStateDataElement,
-                                   freeStateKeyElement,
-                                   compareStateKeyElements);
+    // the IDs are kept inline in the pooled nodes
+    eurovision->States = mapCreatePooled(copyStateDataElement,
+                                         copyStateKeyElement,
+                                         freeStateDataElement,
+                                         freeStateKeyElement,
+                                         compareStateKeyElements,
+                                         MAP_BACKEND_SKIP_LIST, sizeof(int), 0);
     if (!eurovision->States) {
         free(eurovision);
         return NULL;                    // allocation failed
     }
 
-    // create the Judges map using the appropriate functions (from judge.h)
-    eurovision->Judges = mapCreate(copyJudgeDataElement,
-                                   copyJudgeKeyElement,
-                                   freeJudgeDataElement,
-                                   freeJudgeKeyElement,
-                                   compareJudgeKeyElements);
+    // create the Judges map (a typed map from judge.h, the IDs are kept inline)
+    eurovision->Judges = judgeMapCreate();
 
-    //check mapCreate return value
+    //check judgeMapCreate return value
     if (!eurovision->Judges) {
         mapDestroy(eurovision->States);
         free(eurovision);
         return NULL;                    // allocation failed
     }
 
+    eurovision->Friends = friendlyPairsCreate();
+    if (!eurovision->Friends) {
+        mapDestroy(eurovision->States);
+        judgeMapDestroy(eurovision->Judges);
+        free(eurovision);
+        return NULL;                    // allocation failed
+    }
+
+    if (pthread_mutex_init(&eurovision->cache_lock, NULL) != 0) {
+        mapDestroy(eurovision->States);
+        judgeMapDestroy(eurovision->Judges);
+        friendlyPairsDestroy(eurovision->Friends);
+        free(eurovision);
+        return NULL;                    // no resources for the lock
+    }
+
+    eurovision->tally_pool = NULL;     // tally on the calling thread by default
+
+    // nothing is computed yet
+    eurovision->generation = 0;
+    eurovision->cache = (ResultsCache){ .generation = 0 };
+
     return eurovision;
 }
 
+Eurovision eurovisionClone(Eurovision eurovision) {
+    if (!eurovision) return NULL;       // NULL pointer received
+
+    Eurovision clone = malloc(sizeof(*clone));
+    if (!clone) return NULL;            // allocation failed
+
+    // the copies of the states share their names and votes with the original states until
+    // one of them changes (see copyStateDataElement), and the judges are shared as they are
+    clone->States = mapCopy(eurovision->States);
+    clone->Judges = judgeMapCopy(eurovision->Judges);
+    clone->Friends = friendlyPairsCopy(eurovision->Friends);
+
+    // the clone tallies with threads of its own
+    int thread_count = tallyPoolGetThreadCount(eurovision->tally_pool);
+    clone->tally_pool = (thread_count > 1) ? tallyPoolCreate(thread_count) : NULL;
+
+    if (!clone->States || !clone->Judges || !clone->Friends || (thread_count > 1 && !clone->tally_pool) ||
+        pthread_mutex_init(&clone->cache_lock, NULL) != 0) {
+        mapDestroy(clone->States);
+        judgeMapDestroy(clone->Judges);
+        friendlyPairsDestroy(clone->Friends);
+        tallyPoolDestroy(clone->tally_pool);
+        free(clone);
+        return NULL;                    // allocation failed
+    }
+
+    // the clone starts with the same results, but computes them again if asked
+    clone->generation = eurovision->generation;
+    clone->cache = (ResultsCache){ .generation = eurovision->generation };
+
+    return clone;
+}
+
 void eurovisionDestroy(Eurovision eurovision) {
     if (eurovision) {
         // destroy the States and Judges maps:
-        mapDestroy(eurovision->States);     // votes maps are destroyed in the freeStateDataElement function
-        mapDestroy(eurovision->Judges);
+        mapDestroy(eurovision->States);     // votes are destroyed in the freeStateDataElement function
+        judgeMapDestroy(eurovision->Judges);
+        friendlyPairsDestroy(eurovision->Friends);
+        cacheClear(&eurovision->cache);
+        pthread_mutex_destroy(&eurovision->cache_lock);
+        tallyPoolDestroy(eurovision->tally_pool);  // stops the tally threads
 
         free(eurovision);                   // free the eurovision struct
     }
@@ -76,17 +236,18 @@ EurovisionResult eurovisionAddState(Eurovision eurovision, int stateId,
     }
     /// PARAMETER CHECKS ///
 
-    // temporarily allocate memory for the state's data
+    eurovision->generation++;      // a new state changes every result
+
+    // allocate memory for the state's data
     StateData state_data = stateDataCreate(stateName, songName);
     if (!state_data) return EUROVISION_OUT_OF_MEMORY;   // state's data allocation failed
 
-    // add the state to Eurovision's States
-    MapResult put_result = mapPut(eurovision->States, &stateId, state_data);
-
-    // deallocate the temporary state data
-    freeStateDataElement(state_data);
-
-    if (put_result == MAP_OUT_OF_MEMORY) return EUROVISION_OUT_OF_MEMORY;           // copy in mapPut failed
+    // add the state to Eurovision's States (the map takes the state's data without copying it)
+    MapResult put_result = mapPutMove(eurovision->States, &stateId, state_data);
+    if (put_result == MAP_OUT_OF_MEMORY) {
+        freeStateDataElement(state_data);               // node allocation in mapPutMove failed
+        return EUROVISION_OUT_OF_MEMORY;
+    }
 
     return EUROVISION_SUCCESS;
 }
@@ -100,32 +261,49 @@ EurovisionResult eurovisionRemoveState(Eurovision eurovision, int stateId) {
     }
     /// PARAMETER CHECKS ///
 
-    // for each state in Eurovision, remove the votes that state has for given stateId
-    MAP_FOREACH(int *, id, eurovision->States) {
-        StateData state_data = mapGet(eurovision->States, id);
-        assert(stateGetVotes(state_data) != NULL);
-        mapRemove(stateGetVotes(state_data), &stateId);
+    StateData removed_data = mapGet(eurovision->States, &stateId);
+
+    // copy all the states that are about to change if they're shared with a clone,
+    // so the removal can't fail after it starts
+    if (!makeRemovalWritable(eurovision, removed_data)) return EUROVISION_OUT_OF_MEMORY;
+
+    eurovision->generation++;      // the removal changes the results
+
+    // for each state that votes for the given stateId, remove its votes for stateId
+    INT_MAP_FOREACH(IntIntMapEntry, giver, stateGetGivers(removed_data)) {
+        StateData state_data = mapGet(eurovision->States, &giver->key);
+        Votes votes = stateGetVotes(state_data);
+        assert(votes != NULL);
+
+        // update the scoreboard with the places that changed in the state's ranking
+        int old_results[NUMBER_OF_RANKINGS], new_results[NUMBER_OF_RANKINGS];
+        getStateResults(votes, old_results);
+        bool removed = votesRemove(votes, stateId);
+        assert(removed);
+        (void)removed;
+        getStateResults(votes, new_results);
+        scoreboardUpdateRanking(eurovision->States, old_results, new_results);
+        friendlyPairsUpdate(eurovision->Friends, eurovision->States, giver->key, state_data,
+                            old_results[0]);
     }
 
-    // make helper int list for saving the IDs of judges we want to remove
-    List judges_to_remove = listCreate(copyInt, freeInt);
-    if (!judges_to_remove) return EUROVISION_OUT_OF_MEMORY;
-
-
-    // for each judge in Eurovision, remove it if it voted for the given stateId
-    MAP_FOREACH(int *, judge_id, eurovision->Judges) {
-        JudgeData judgeData = mapGet(eurovision->Judges, judge_id);
-        if (judgeResultsContain(judgeData, stateId)) {
-            listInsertFirst(judges_to_remove, judge_id);
-        }
+    // remove the given stateId from the givers of the states it votes for
+    Votes removed_votes = stateGetVotes(removed_data);
+    INT_MAP_FOREACH(IntIntMapEntry, taker, votesGetCounts(removed_votes)) {
+        intIntMapRemove(stateGetGivers(mapGet(eurovision->States, &taker->key)), stateId);
     }
 
-    // remove the judges
-    LIST_FOREACH(int *, judge_id, judges_to_remove) {
-        eurovisionRemoveJudge(eurovision, *judge_id);
+    // remove the judges that ranked the given stateId
+    // (removing a judge also removes it from the state's judges, so the first one is always a new one)
+    IntIntMap state_judges = stateGetJudges(removed_data);
+    while (intIntMapGetSize(state_judges) > 0) {
+        eurovisionRemoveJudge(eurovision, intIntMapGetEntries(state_judges)[0].key);
     }
 
-    listDestroy(judges_to_remove);  // deallocate the helper list
+    // take back the points the state gave to the other states
+    int state_results[NUMBER_OF_RANKINGS];
+    getStateResults(removed_votes, state_results);
+    scoreboardApplyRanking(eurovision->States, state_results, -1, false);
 
     // Remove the state from Eurovision's States
     mapRemove(eurovision->States, &stateId);
@@ -150,22 +328,33 @@ EurovisionResult eurovisionAddJudge(Eurovision eurovision, int judgeId,
     }
     if (!isValidName(judgeName)) return EUROVISION_INVALID_NAME;    // judge name not valid
     if (!state_exist) return EUROVISION_STATE_NOT_EXIST;            // state in judge results doesn't exist
-    if (mapContains(eurovision->Judges, &judgeId)) {
+    if (judgeMapContains(eurovision->Judges, judgeId)) {
         return EUROVISION_JUDGE_ALREADY_EXIST;                      // judge already exists
     }
     /// PARAMETER CHECKS ///
 
-    // temporarily allocate memory for the judge's data
+    eurovision->generation++;      // the judge's points change the contest results
+
+    // allocate memory for the judge's data
     JudgeData judge_data = judgeDataCreate(judgeName, judgeResults);
     if (!judge_data) return EUROVISION_OUT_OF_MEMORY;   // judge's data allocation failed
 
-    // add the judge to Eurovision's Judges
-    MapResult put_result = mapPut(eurovision->Judges, &judgeId, judge_data);
+    // add the judge to the judges of the states it ranked
+    if (!judgeIndexAdd(eurovision->States, judgeId, judgeResults)) {
+        freeJudgeDataElement(judge_data);
+        return EUROVISION_OUT_OF_MEMORY;
+    }
 
-    // deallocate the temporary judge data
-    freeJudgeDataElement(judge_data);
+    // add the judge to Eurovision's Judges (the map takes the judge's data without copying it)
+    MapResult put_result = judgeMapPut(eurovision->Judges, judgeId, judge_data);
+    if (put_result == MAP_OUT_OF_MEMORY) {
+        judgeIndexRemove(eurovision->States, judgeId, judgeResults);
+        freeJudgeDataElement(judge_data);               // the map's array couldn't grow
+        return EUROVISION_OUT_OF_MEMORY;
+    }
 
-    if (put_result == MAP_OUT_OF_MEMORY) return EUROVISION_OUT_OF_MEMORY;   // copy in mapPut failed
+    // give the judge's points to the states on the scoreboard
+    scoreboardApplyRanking(eurovision->States, judgeResults, 1, true);
 
     return EUROVISION_SUCCESS;
 }
@@ -174,105 +363,349 @@ EurovisionResult eurovisionRemoveJudge(Eurovision eurovision, int judgeId) {
     /// PARAMETER CHECKS ///
     if (!eurovision) return EUROVISION_NULL_ARGUMENT;       // NULL pointer received
     if (judgeId < 0) return EUROVISION_INVALID_ID;          // ID not valid
-    if (!mapContains(eurovision->Judges, &judgeId)) {
+    if (!judgeMapContains(eurovision->Judges, judgeId)) {
         return EUROVISION_JUDGE_NOT_EXIST;                  // judge doesn't exist
     }
     /// PARAMETER CHECKS ///
 
+    // remove the judge from the judges of the states it ranked
+    JudgeData judge_data = *judgeMapGet(eurovision->Judges, judgeId);
+    if (!judgeIndexRemove(eurovision->States, judgeId, judgeGetResults(judge_data))) {
+        return EUROVISION_OUT_OF_MEMORY;    // the states are shared with a clone and copying them failed
+    }
+
+    eurovision->generation++;      // the judge's points are taken back
+
+    // take back the judge's points from the states on the scoreboard
+    scoreboardApplyRanking(eurovision->States, judgeGetResults(judge_data), -1, true);
+
     // Remove the judge from Eurovision's Judges
-    mapRemove(eurovision->Judges, &judgeId);
+    judgeMapRemove(eurovision->Judges, judgeId);
 
     return EUROVISION_SUCCESS;
 }
 
 EurovisionResult eurovisionAddVote(Eurovision eurovision, int stateGiver,
                                    int stateTaker) {
-    // add one vote to stateTaker in the stateGiver's votes map
-    return eurovisionChangeVote(eurovision->States, stateGiver, stateTaker, 1);
+    if (!eurovision) return EUROVISION_NULL_ARGUMENT;   // NULL pointer received
+
+    // add one vote to stateTaker in the stateGiver's votes
+    EurovisionResult result = eurovisionChangeVote(eurovision->States, eurovision->Friends,
+                                                   stateGiver, stateTaker, 1);
+    if (result == EUROVISION_SUCCESS) eurovision->generation++;     // the vote may change the results
+
+    return result;
 }
 
 
 EurovisionResult eurovisionRemoveVote(Eurovision eurovision, int stateGiver,
                                       int stateTaker) {
-    // remove one vote from stateTaker in the stateGiver's votes map
-    return eurovisionChangeVote(eurovision->States, stateGiver, stateTaker, -1);
+    if (!eurovision) return EUROVISION_NULL_ARGUMENT;   // NULL pointer received
+
+    // remove one vote from stateTaker in the stateGiver's votes
+    EurovisionResult result = eurovisionChangeVote(eurovision->States, eurovision->Friends,
+                                                   stateGiver, stateTaker, -1);
+    if (result == EUROVISION_SUCCESS) eurovision->generation++;
+
+    return result;
+}
+
+EurovisionResult eurovisionAddVotes(Eurovision eurovision,
+                                    const VoteDelta *deltas, size_t n) {
+    if (!eurovision) return EUROVISION_NULL_ARGUMENT;   // NULL pointer received
+
+    // change the votes of all the deltas, grouped by their stateGiver
+    EurovisionResult result = eurovisionChangeVotes(eurovision->States, eurovision->Friends, deltas, n);
+
+    // some of the deltas may have been applied before an allocation failed
+    if (result == EUROVISION_SUCCESS || result == EUROVISION_OUT_OF_MEMORY) {
+        eurovision->generation++;
+    }
+
+    return result;
+}
+
+EurovisionResult eurovisionSetThreadCount(Eurovision eurovision, int threadCount) {
+    if (!eurovision) return EUROVISION_NULL_ARGUMENT;     // NULL pointer received
+
+    // less than one thread means tallying on the calling thread
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount == tallyPoolGetThreadCount(eurovision->tally_pool)) return EUROVISION_SUCCESS;
+
+    // the threads are started here once, and wait for the tallies until the count changes again
+    TallyPool pool = NULL;
+    if (threadCount > 1) {
+        pool = tallyPoolCreate(threadCount);
+        if (!pool) return EUROVISION_OUT_OF_MEMORY;     // the old threads are kept
+    }
+    tallyPoolDestroy(eurovision->tally_pool);
+
+    // (the results are the same for any thread count, so the cached ones stay valid)
+    eurovision->tally_pool = pool;
+
+    return EUROVISION_SUCCESS;
 }
 
 List eurovisionRunContest(Eurovision eurovision, int audiencePercent) {
-    if (!eurovision || audiencePercent > 100 || audiencePercent < 0) return NULL;   // invalid parameter received
+    if (!eurovision) return NULL;   // NULL pointer received
+
+    // rank all the states
+    return eurovisionRunContestTopK(eurovision, audiencePercent, mapGetSize(eurovision->States));
+}
+
+List eurovisionRunContestTopK(Eurovision eurovision, int audiencePercent, int k) {
+    if (!eurovision || audiencePercent > 100 || audiencePercent < 0 || k < 0) return NULL;   // invalid parameter received
 
     // if state map is empty return empty string List
-    if (mapGetFirst(eurovision->States) == NULL) return listCreate(copyString, freeString);
+    int num_of_states = mapGetSize(eurovision->States);
+    if (num_of_states == 0) return listCreate(copyString, freeString);
+    if (k > num_of_states) k = num_of_states;
+
+    pthread_mutex_lock(&eurovision->cache_lock);
+    List ranking = cachedContest(eurovision, audiencePercent, k);
+    pthread_mutex_unlock(&eurovision->cache_lock);
+
+    return ranking;
+}
+
+List *eurovisionRunContestSweep(Eurovision eurovision, const int *percents, size_t n) {
+    if (!eurovision || !percents || n == 0) return NULL;   // invalid parameter received
+    for (size_t i = 0; i < n; i++) {
+        if (percents[i] > 100 || percents[i] < 0) return NULL;  // invalid percent received
+    }
+
+    List *rankings = calloc(n, sizeof(*rankings));
+    if (!rankings) return NULL;
+
+    pthread_mutex_lock(&eurovision->cache_lock);
+    bool ranked = cachedContestSweep(eurovision, percents, rankings, n);
+    pthread_mutex_unlock(&eurovision->cache_lock);
+    if (!ranked) {
+        free(rankings);
+        return NULL;
+    }
+
+    return rankings;
+}
 
-    // get the points each state got from the audience
-    List points_list = getAudiencePoints(eurovision->States);
-    if (!points_list) return NULL;
+List eurovisionGetStandings(Eurovision eurovision, int audiencePercent) {
+    if (!eurovision || audiencePercent > 100 || audiencePercent < 0) return NULL;   // invalid parameter received
+
+    // get the points each state has on the scoreboard (no new tally)
+    PointVector points_vector = getScoreboardPoints(eurovision->States, false);
+    if (!points_vector) return NULL;
 
-    // get the list of points each state got from the judges
-    List judge_points = getJudgesPoints(eurovision->Judges, eurovision->States);
+    PointVector judge_points = getScoreboardPoints(eurovision->States, true);
     if (!judge_points) {
-        listDestroy(points_list);
+        pointVectorDestroy(points_vector);
         return NULL;
     }
 
-    // get number of states and judges for the final calculation
+    return rankStates(eurovision, points_vector, judge_points, audiencePercent,
+                      mapGetSize(eurovision->States));
+}
+
+List eurovisionRunAudienceFavorite(Eurovision eurovision) {
+    if (!eurovision) return NULL;   // NULL pointer received
+
+    pthread_mutex_lock(&eurovision->cache_lock);
+    List ranking = cachedAudienceFavorite(eurovision);
+    pthread_mutex_unlock(&eurovision->cache_lock);
+
+    return ranking;
+}
+
+List eurovisionRunGetFriendlyStates(Eurovision eurovision) {
+    if (!eurovision) return NULL;   // NULL pointer received
+
+    // if state map is empty return empty List
+    if (mapGetSize(eurovision->States) == 0) return listCreate(copyString, freeString);
+
+    pthread_mutex_lock(&eurovision->cache_lock);
+    List friendly_states = cachedFriendlyStates(eurovision);
+    pthread_mutex_unlock(&eurovision->cache_lock);
+
+    return friendly_states;
+}
+
+
+static List cachedContest(Eurovision eurovision, int audience_percent, int k) {
+    int num_of_states = mapGetSize(eurovision->States);
+
+    // the last contest's ranking can be reused if nothing changed and it's sorted far enough
+    cacheSync(eurovision);
+    ResultsCache *cache = &eurovision->cache;
+    if (!cache->contest_ranking || cache->contest_percent != audience_percent || cache->contest_count < k) {
+        // get the points each state got from the audience and from the judges (once per generation)
+        if (!cacheTallies(eurovision)) return NULL;
+
+        PointVector final_points = pointVectorCreate(num_of_states);
+        if (!final_points) return NULL;
+
+        // Calculate the final points for each state, and sort only the top k states
+        calculateFinalPoints(cache->audience_points, cache->judge_points, final_points,
+                             num_of_states, judgeMapGetSize(eurovision->Judges), audience_percent);
+        pointVectorPartialSort(final_points, k);
+
+        pointVectorDestroy(cache->contest_ranking);
+        cache->contest_ranking = final_points;
+        cache->contest_percent = audience_percent;
+        cache->contest_count = k;
+    }
+
+    // convert sorted part of the point vector to string list of states' names
+    return convertToStringList(cache->contest_ranking, k, eurovision->States);
+}
+
+static bool cachedContestSweep(Eurovision eurovision, const int *percents, List *rankings, size_t n) {
+    // tally the audience and judge points once for all the percents (and once per generation)
+    cacheSync(eurovision);
     int num_of_states = mapGetSize(eurovision->States);
-    int num_of_judges = mapGetSize(eurovision->Judges);
+    PointVector final_points = pointVectorCreate(num_of_states);
+    if (!final_points || !cacheTallies(eurovision)) {
+        pointVectorDestroy(final_points);
+        return false;
+    }
+    PointVector audience_points = eurovision->cache.audience_points;
+    PointVector judge_points = eurovision->cache.judge_points;
+
+    int num_of_judges = judgeMapGetSize(eurovision->Judges);
+    bool ranked = true;
+    for (size_t i = 0; i < n && ranked; i++) {
+        // combine the tallies into the final points of this percent, and rank the states
+        calculateFinalPoints(audience_points, judge_points, final_points,
+                             num_of_states, num_of_judges, percents[i]);
+        pointVectorSort(final_points);
+        rankings[i] = convertToStringList(final_points, num_of_states, eurovision->States);
+        if (!rankings[i]) {
+            destroyLists(rankings, i);
+            ranked = false;
+        }
+    }
+
+    pointVectorDestroy(final_points);
 
-    // Calculate the final points for each state
-    calculateFinalPoints(points_list, judge_points,
-                         num_of_states, num_of_judges, audiencePercent);
+    return ranked;
+}
+
+static List cachedAudienceFavorite(Eurovision eurovision) {
+    cacheSync(eurovision);
+    ResultsCache *cache = &eurovision->cache;
+    if (!cache->audience_ranking) {
+        // get the points each state got from the audience (once per generation)
+        if (!cacheTallies(eurovision)) return NULL;  // error in getAudiencePoints function
+
+        // sort a copy of the tally, the tally itself stays in the states' order
+        cache->audience_ranking = pointVectorCopy(cache->audience_points);
+        if (!cache->audience_ranking) return NULL;
+        pointVectorSort(cache->audience_ranking);
+    }
 
-    listDestroy(judge_points);      // deallocate the judge points list
+    // convert sorted point vector to sorted string list of states' names
+    return convertToStringList(cache->audience_ranking, pointVectorGetSize(cache->audience_ranking),
+                               eurovision->States);
+}
 
-    // sort the final points list
-    if (listSort(points_list, compareStatePoints) != LIST_SUCCESS) {
-        listDestroy(points_list);
-        return NULL;                // sort failed
+static List cachedFriendlyStates(Eurovision eurovision) {
+    cacheSync(eurovision);
+    ResultsCache *cache = &eurovision->cache;
+    if (!cache->friendly_states) {
+        // the friendly pairs are kept up to date and sorted (or rebuilt here after a failed update)
+        cache->friendly_states = friendlyPairsGetList(eurovision->Friends, eurovision->States);
+        if (!cache->friendly_states) return NULL;
     }
 
-    // convert sorted points list to string list of states' names
-    List final_results = convertToStringList(points_list, eurovision->States);
+    // the caller gets its own copy of the list
+    return listCopy(cache->friendly_states);
+}
+
+static List rankStates(Eurovision eurovision, PointVector audience_points,
+                       PointVector judge_points, int audience_percent, int count) {
+    // get number of states and judges for the final calculation
+    int num_of_states = mapGetSize(eurovision->States);
+    int num_of_judges = judgeMapGetSize(eurovision->Judges);
+
+    // Calculate the final points for each state (in place of the audience points)
+    calculateFinalPoints(audience_points, judge_points, audience_points,
+                         num_of_states, num_of_judges, audience_percent);
+
+    pointVectorDestroy(judge_points);       // deallocate the judge point vector
+
+    // sort the count highest final points in place (the rest stay unsorted)
+    pointVectorPartialSort(audience_points, count);
+
+    // convert sorted part of the point vector to string list of states' names
+    List final_results = convertToStringList(audience_points, count, eurovision->States);
 
-    listDestroy(points_list);       // deallocate the points list
+    pointVectorDestroy(audience_points);    // deallocate the point vector
 
     return final_results;           // return the sorted state names list
 }
 
-List eurovisionRunAudienceFavorite(Eurovision eurovision) {
-    if (!eurovision) return NULL;   // NULL pointer received
+static bool makeRemovalWritable(Eurovision eurovision, StateData removed_data) {
+    // first the removed state itself, so its ballots don't change during the loops
+    // (its judges ranked it too)
+    if (!stateMakeWritable(removed_data)) return false;
 
-    // get the points each state got from the audience
-    List audience_points = getAudiencePoints(eurovision->States);
-    if (!audience_points) return NULL;  // error in getAudiencePoints function
+    // the states that vote for the removed state lose their votes for it
+    INT_MAP_FOREACH(IntIntMapEntry, giver, stateGetGivers(removed_data)) {
+        if (!stateMakeWritable(mapGet(eurovision->States, &giver->key))) return false;
+    }
 
-    // sort the list
-    if (listSort(audience_points, compareStatePoints) != LIST_SUCCESS) {
-        listDestroy(audience_points);
-        return NULL;                    // list sort failed
+    // the states it votes for lose it from their givers
+    INT_MAP_FOREACH(IntIntMapEntry, taker, votesGetCounts(stateGetVotes(removed_data))) {
+        if (!stateMakeWritable(mapGet(eurovision->States, &taker->key))) return false;
     }
 
-    // convert sorted points list to sorted string list of states' names
-    List final_results = convertToStringList(audience_points, eurovision->States);
+    // its judges are removed from all the states they ranked
+    INT_MAP_FOREACH(IntIntMapEntry, judge, stateGetJudges(removed_data)) {
+        JudgeData judge_data = *judgeMapGet(eurovision->Judges, judge->key);
+        if (!statesMakeWritable(eurovision->States, judgeGetResults(judge_data))) return false;
+    }
 
-    listDestroy(audience_points);       // deallocate the audience points list
+    return true;
+}
 
-    return final_results;
+static void destroyLists(List *lists, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        listDestroy(lists[i]);
+    }
+    free(lists);
 }
 
-List eurovisionRunGetFriendlyStates(Eurovision eurovision) {
-    // if state map is empty return empty List
-    if (mapGetSize(eurovision->States) == 0) return listCreate(copyString, freeString);
+static void cacheClear(ResultsCache *cache) {
+    pointVectorDestroy(cache->audience_points);
+    pointVectorDestroy(cache->judge_points);
+    pointVectorDestroy(cache->contest_ranking);
+    pointVectorDestroy(cache->audience_ranking);
+    listDestroy(cache->friendly_states);
+
+    cache->audience_points = NULL;
+    cache->judge_points = NULL;
+    cache->contest_ranking = NULL;
+    cache->audience_ranking = NULL;
+    cache->friendly_states = NULL;
+}
+
+static void cacheSync(Eurovision eurovision) {
+    if (eurovision->cache.generation != eurovision->generation) {
+        cacheClear(&eurovision->cache);     // computed before the last change
+        eurovision->cache.generation = eurovision->generation;
+    }
+}
 
-    List friendly_states = getFriendlyStates(eurovision->States);
-    if (!friendly_states) return NULL;      // error in getFriendlyStates function
+static bool cacheTallies(Eurovision eurovision) {
+    ResultsCache *cache = &eurovision->cache;
+    assert(cache->generation == eurovision->generation);
 
-    // sort the strings array lexicographically
-    if (listSort(friendly_states, stringCompare) != LIST_SUCCESS) {
-        listDestroy(friendly_states);
-        return NULL;                        // list sort failed
+    if (!cache->audience_points) {
+        cache->audience_points = getAudiencePoints(eurovision->States, eurovision->tally_pool);
+        if (!cache->audience_points) return false;
+    }
+    if (!cache->judge_points) {
+        cache->judge_points = getJudgesPoints(eurovision->Judges, eurovision->States);
+        if (!cache->judge_points) return false;
     }
 
-    return friendly_states;
+    return true;
 }
-
@@ -1,6 +1,7 @@
 #ifndef EUROVISION_H_
 #define EUROVISION_H_
 
+#include <stddef.h>
 #include "list.h"
 
 typedef enum eurovisionResult_t {
@@ -19,10 +20,27 @@ typedef enum eurovisionResult_t {
 
 typedef struct eurovision_t *Eurovision;
 
+typedef struct voteDelta_t {
+    int stateGiver;
+    int stateTaker;
+    int count;  // number of votes to add (negative to remove votes)
+} VoteDelta;
+
 Eurovision eurovisionCreate();
 
 void eurovisionDestroy(Eurovision eurovision);
 
+/*
+ * Creates a copy of a eurovision that shares its states' votes and its judges
+ * with the original, and copies a state's votes only when one of them changes it.
+ * The shared data is reference counted without locks: a eurovision and all the
+ * clones made from it (directly or through other clones) must be changed, cloned
+ * and destroyed from one thread at a time. Queries on one of them may run while
+ * another one is used on a different thread, as long as that one isn't changed,
+ * cloned or destroyed meanwhile.
+ */
+Eurovision eurovisionClone(Eurovision eurovision);
+
 EurovisionResult eurovisionAddState(Eurovision eurovision, int stateId,
                                     const char *stateName,
                                     const char *songName);
@@ -41,8 +59,32 @@ EurovisionResult eurovisionAddVote(Eurovision eurovision, int stateGiver,
 EurovisionResult eurovisionRemoveVote(Eurovision eurovision, int stateGiver,
                                       int stateTaker);
 
+EurovisionResult eurovisionAddVotes(Eurovision eurovision,
+                                    const VoteDelta *deltas, size_t n);
+
+EurovisionResult eurovisionSetThreadCount(Eurovision eurovision, int threadCount);
+
+/*
+ * The queries below can be called on one eurovision from several threads at once:
+ * they share its cached results under a lock, so a result is computed only once
+ * per change. The eurovision must not be changed while it's being queried.
+ */
 List eurovisionRunContest(Eurovision eurovision, int audiencePercent);
 
+List eurovisionRunContestTopK(Eurovision eurovision, int audiencePercent, int k);
+
+/*
+ * Runs the contest once for each of the n audience percents, tallying the votes
+ * only once. Returns an array of n rankings, in the order of the percents, each
+ * like the list eurovisionRunContest returns for its percent. The caller destroys
+ * each list with listDestroy and then frees the array with free.
+ * Returns NULL if n is 0, if an argument is NULL or a percent is invalid, or if any
+ * one of the rankings can't be made (then no ranking is returned).
+ */
+List *eurovisionRunContestSweep(Eurovision eurovision, const int *percents, size_t n);
+
+List eurovisionGetStandings(Eurovision eurovision, int audiencePercent);
+
 List eurovisionRunAudienceFavorite(Eurovision eurovision);
 
 List eurovisionRunGetFriendlyStates(Eurovision eurovision);
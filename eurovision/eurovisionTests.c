@@ -3,7 +3,11 @@
 #include <string.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <pthread.h>
 #include "list.h"
+#include "map.h"
+#include "intmap.h"
+#include "functions.h"
 #include "eurovision.h"
 #include "eurovisionTests.h"
 
@@ -24,6 +28,14 @@
       return false;                             \
     } while(0)
 
+/* for tests without a eurovision, cleanup is a statement that frees what the test made */
+#define CHECK_WITH_CLEANUP(b,res,cleanup)       \
+  if((b) != (res)) do{                          \
+      printf("fail: %s != %s\n", #b, #res);     \
+      cleanup;                                  \
+      return false;                             \
+    } while(0)
+
 static Eurovision setupEurovision() {
   Eurovision eurovision = eurovisionCreate();
   assert(eurovision);
@@ -103,6 +115,12 @@ static void giveVotes(Eurovision eurovision, int giver, int taker, int votes) {
       printf("error in eurovisionAddVote %d -> %d\n", giver, taker);
     }
   }
+  /* a negative number of votes removes votes */
+  for (int i = 0; i > votes; i--) {
+    if (eurovisionRemoveVote(eurovision, giver, taker) != EUROVISION_SUCCESS) {
+      printf("error in eurovisionRemoveVote %d -> %d\n", giver, taker);
+    }
+  }
 }
 
 static void setupEurovisionVotes(Eurovision eurovision) {
@@ -234,6 +252,35 @@ bool testAddVote() {
   return true;
 }
 
+bool testAddVotes() {
+  Eurovision eurovision = setupEurovision();
+  setupEurovisionStates(eurovision);
+  VoteDelta invalid[] = { { 1, 2, 3 }, { 12, -1, 1 } };
+  CHECK(eurovisionAddVotes(eurovision, invalid, 2), EUROVISION_INVALID_ID);
+  VoteDelta missing[] = { { 1, 2, 3 }, { 100, 12, 1 } };
+  CHECK(eurovisionAddVotes(eurovision, missing, 2), EUROVISION_STATE_NOT_EXIST);
+  VoteDelta same[] = { { 1, 2, 3 }, { 12, 12, 1 } };
+  CHECK(eurovisionAddVotes(eurovision, same, 2), EUROVISION_SAME_STATE);
+  CHECK(eurovisionAddVotes(eurovision, NULL, 1), EUROVISION_NULL_ARGUMENT);
+  CHECK(eurovisionAddVotes(eurovision, NULL, 0), EUROVISION_SUCCESS);
+
+  /* none of the failed batches changed anything, so malta and croatia
+   * are friendly only after this batch (removing votes with a negative count) */
+  VoteDelta batch[] = { { 2, 1, 5 }, { 1, 3, 4 }, { 1, 2, 3 }, { 2, 1, -2 }, { 1, 3, -4 } };
+  CHECK(eurovisionAddVotes(eurovision, batch, 5), EUROVISION_SUCCESS);
+  List friendlies = eurovisionRunGetFriendlyStates(eurovision);
+  CHECK(listGetSize(friendlies), 1);
+  char *current = (char *)listGetFirst(friendlies);
+  if (strcmp(current, "croatia - malta") != 0) {
+    listDestroy(friendlies);
+    CHECK(strcmp(current, "croatia - malta"), 0);
+  }
+  listDestroy(friendlies);
+
+  eurovisionDestroy(eurovision);
+  return true;
+}
+
 bool testRemoveVote() {
   Eurovision eurovision = setupEurovision();
   setupEurovisionStates(eurovision);
@@ -251,6 +298,70 @@ bool testRemoveVote() {
   return true;
 }
 
+/* israel votes for states 1..12, state i gets 13-i votes.
+ * removing the votes of a ranked state brings the 11th state into the ranking */
+bool testRemoveVoteReranks() {
+  Eurovision eurovision = setupEurovision();
+  setupEurovisionStates(eurovision);
+  for (int taker = 1; taker <= 12; taker++) {
+    giveVotes(eurovision, 0, taker, 13 - taker);
+  }
+  giveVotes(eurovision, 0, 1, -12);
+
+  List ranking = eurovisionRunAudienceFavorite(eurovision);
+  char *current = (char*)listGetFirst(ranking);
+  bool correct = (strcmp(current, "croatia") == 0);
+  for (int place = 1; place < 10; place++) {
+    current = (char*)listGetNext(ranking);
+  }
+  correct = correct && (strcmp(current, "armenia") == 0);
+  listDestroy(ranking);
+  CHECK(correct, true);
+
+  /* austria ties with russia and ranks after it (bigger ID), armenia drops out */
+  giveVotes(eurovision, 0, 12, 9);
+  ranking = eurovisionRunAudienceFavorite(eurovision);
+  current = (char*)listGetFirst(ranking);
+  correct = (strcmp(current, "croatia") == 0);
+  current = (char*)listGetNext(ranking);
+  correct = correct && (strcmp(current, "russia") == 0);
+  current = (char*)listGetNext(ranking);
+  correct = correct && (strcmp(current, "austria") == 0);
+  current = (char*)listGetNext(ranking);
+  correct = correct && (strcmp(current, "moldova") == 0);
+  listDestroy(ranking);
+  CHECK(correct, true);
+
+  /* croatia drops to 3 votes, still ahead of united kingdom in the last place */
+  giveVotes(eurovision, 0, 2, -8);
+  ranking = eurovisionRunAudienceFavorite(eurovision);
+  current = (char*)listGetFirst(ranking);
+  for (int place = 1; place < 9; place++) {
+    current = (char*)listGetNext(ranking);
+  }
+  correct = (strcmp(current, "croatia") == 0);
+  current = (char*)listGetNext(ranking);
+  correct = correct && (strcmp(current, "united kingdom") == 0);
+  listDestroy(ranking);
+  CHECK(correct, true);
+
+  /* croatia drops below the last place, armenia is back in the ranking */
+  giveVotes(eurovision, 0, 2, -2);
+  ranking = eurovisionRunAudienceFavorite(eurovision);
+  current = (char*)listGetFirst(ranking);
+  for (int place = 1; place < 9; place++) {
+    current = (char*)listGetNext(ranking);
+  }
+  correct = (strcmp(current, "united kingdom") == 0);
+  current = (char*)listGetNext(ranking);
+  correct = correct && (strcmp(current, "armenia") == 0);
+  listDestroy(ranking);
+  CHECK(correct, true);
+
+  eurovisionDestroy(eurovision);
+  return true;
+}
+
 /** combined scores:
  * 10: 0.75   * 0.4 + 6.6667 * 0.6 = 4.3 (united kingdom)
  * 4:  1.6875 * 0.4 + 6      * 0.6 = 4.275 (moldova)
@@ -293,6 +404,558 @@ bool testRunContest() {
   return true;
 }
 
+bool testRunContestTopK() {
+  Eurovision eurovision = setupEurovision();
+  setupEurovisionStates(eurovision);
+  setupEurovisionJudges(eurovision);
+  setupEurovisionVotes2(eurovision);
+
+  CHECK(eurovisionRunContestTopK(NULL, 40, 3), NULL);
+  CHECK(eurovisionRunContestTopK(eurovision, 40, -1), NULL);
+  CHECK(eurovisionRunContestTopK(eurovision, 101, 3), NULL);
+
+  List podium = eurovisionRunContestTopK(eurovision, 40, 3);
+  CHECK(listGetSize(podium), 3);
+  char *current = (char*)listGetFirst(podium);
+  CHECK(strcmp(current, "united kingdom"), 0);
+  current = (char*)listGetNext(podium);
+  CHECK(strcmp(current, "moldova"), 0);
+  current = (char*)listGetNext(podium);
+  CHECK(strcmp(current, "russia"), 0);
+  listDestroy(podium);
+
+  List empty = eurovisionRunContestTopK(eurovision, 40, 0);
+  CHECK(listGetSize(empty), 0);
+  listDestroy(empty);
+
+  /* asking for more states than there are ranks all of them */
+  List all = eurovisionRunContestTopK(eurovision, 40, 100);
+  List ranking = eurovisionRunContest(eurovision, 40);
+  bool same = (listGetSize(all) == 16 && listGetSize(ranking) == 16);
+  char *expected = (char*)listGetFirst(ranking);
+  LIST_FOREACH(char*, name, all) {
+    same = same && strcmp(name, expected) == 0;
+    expected = (char*)listGetNext(ranking);
+  }
+  listDestroy(all);
+  listDestroy(ranking);
+  CHECK(same, true);
+
+  eurovisionDestroy(eurovision);
+  return true;
+}
+
+/* 11 states, 3 judges, 60% audience:
+ * malta:  20 / 10 * 60 + 19 / 3 * 40 = 373.3333
+ * cyprus:  0 / 10 * 60 + 28 / 3 * 40 = 373.3333
+ * the scores are equal, so malta (smaller ID) must rank first,
+ * even though in floating point cyprus' score comes out bigger */
+bool testRunContestExactTie() {
+  Eurovision eurovision = setupEurovision();
+  eurovisionAddState(eurovision, 0, "israel", "home");
+  eurovisionAddState(eurovision, 1, "malta", "chameleon");
+  eurovisionAddState(eurovision, 2, "croatia", "the dream");
+  eurovisionAddState(eurovision, 3, "russia", "scream");
+  eurovisionAddState(eurovision, 4, "moldova", "stay");
+  eurovisionAddState(eurovision, 5, "cyprus", "replay");
+  eurovisionAddState(eurovision, 6, "spain", "la venda");
+  eurovisionAddState(eurovision, 7, "italy", "soldi");
+  eurovisionAddState(eurovision, 8, "france", "roi");
+  eurovisionAddState(eurovision, 9, "germany", "sister");
+  eurovisionAddState(eurovision, 10, "united kingdom", "bigger than us");
+
+  int *results = makeJudgeResults(2, 6, 7, 8, 10, 1, 5, 3, 0, 4);
+  eurovisionAddJudge(eurovision, 0, "olsen", results);
+  free(results);
+  results = makeJudgeResults(5, 10, 1, 7, 4, 9, 6, 0, 3, 8);
+  eurovisionAddJudge(eurovision, 1, "tanel", results);
+  free(results);
+  results = makeJudgeResults(5, 10, 0, 3, 1, 7, 2, 4, 9, 6);
+  eurovisionAddJudge(eurovision, 2, "marie", results);
+  free(results);
+
+  giveVotes(eurovision, 1, 4, 2);
+  giveVotes(eurovision, 1, 0, 1);
+  giveVotes(eurovision, 2, 4, 1);
+  giveVotes(eurovision, 3, 1, 1);
+  giveVotes(eurovision, 4, 10, 3);
+  giveVotes(eurovision, 4, 0, 2);
+  giveVotes(eurovision, 4, 1, 1);
+  giveVotes(eurovision, 6, 7, 1);
+  giveVotes(eurovision, 7, 3, 2);
+  giveVotes(eurovision, 7, 8, 1);
+
+  /* malta must be right before cyprus */
+  List ranking = eurovisionRunContest(eurovision, 60);
+  int malta_place = -1, cyprus_place = -1, place = 0;
+  LIST_FOREACH(char*, name, ranking) {
+    if (strcmp(name, "malta") == 0) malta_place = place;
+    if (strcmp(name, "cyprus") == 0) cyprus_place = place;
+    place++;
+  }
+  listDestroy(ranking);
+  CHECK(malta_place >= 0 && cyprus_place == malta_place + 1, true);
+
+  eurovisionDestroy(eurovision);
+  return true;
+}
+
+bool testGetStandings() {
+  Eurovision eurovision = setupEurovision();
+  setupEurovisionStates(eurovision);
+  setupEurovisionJudges(eurovision);
+  setupEurovisionVotes2(eurovision);
+
+  List standings = eurovisionGetStandings(eurovision, 40);
+  CHECK(listGetSize(standings), 16);
+  char *current = (char*)listGetFirst(standings);
+  CHECK(strcmp(current, "united kingdom"), 0);
+  current = (char*)listGetNext(standings);
+  CHECK(strcmp(current, "moldova"), 0);
+  current = (char*)listGetNext(standings);
+  CHECK(strcmp(current, "russia"), 0);
+  listDestroy(standings);
+
+  /* after removing armenia (and judge 2, who ranked it)
+   * the standings must match a full contest run */
+  CHECK(eurovisionRemoveState(eurovision, 11), EUROVISION_SUCCESS);
+  CHECK(eurovisionRemoveVote(eurovision, 3, 10), EUROVISION_SUCCESS);
+  standings = eurovisionGetStandings(eurovision, 40);
+  List ranking = eurovisionRunContest(eurovision, 40);
+  CHECK(listGetSize(standings), 15);
+  CHECK(listGetSize(ranking), 15);
+  char *expected = (char*)listGetFirst(ranking);
+  LIST_FOREACH(char*, name, standings) {
+    if (strcmp(name, expected) != 0) {
+      listDestroy(standings);
+      listDestroy(ranking);
+      CHECK(strcmp(name, expected), 0);
+    }
+    expected = (char*)listGetNext(ranking);
+  }
+
+  listDestroy(standings);
+  listDestroy(ranking);
+  eurovisionDestroy(eurovision);
+  return true;
+}
+
+/* number states (at most 676) with the IDs 0, id_step, 2 * id_step, ... */
+static void setupManyStates(Eurovision eurovision, int number, int id_step) {
+  char name[] = "state aa";
+  for (int i = 0; i < number; i++) {
+    name[6] = 'a' + i / 26;
+    name[7] = 'a' + i % 26;
+    eurovisionAddState(eurovision, i * id_step, name, "song");
+  }
+  for (int giver = 0; giver < number; giver++) {
+    for (int k = 1; k <= 12; k++) {
+      int taker = (giver * 7 + k * k) % number;
+      if (taker != giver) {
+        giveVotes(eurovision, giver * id_step, taker * id_step, (giver + k) % 5 + 1);
+      }
+    }
+  }
+}
+
+static bool sameLists(List list1, List list2) {
+  if (listGetSize(list1) != listGetSize(list2)) return false;
+  char *expected = (char*)listGetFirst(list2);
+  LIST_FOREACH(char*, name, list1) {
+    if (strcmp(name, expected) != 0) return false;
+    expected = (char*)listGetNext(list2);
+  }
+  return true;
+}
+
+/* a pooled map allocates its nodes in slabs, a plain map allocates each node on its own */
+#define DESTROY_STATS_MAPS do { mapDestroy(plain); mapDestroy(pooled); } while(0)
+bool testMapAllocatorStats() {
+  Map plain = mapCreate(copyInt, copyInt, freeInt, freeInt, compareInts);
+  Map pooled = mapCreatePooled(NULL, NULL, NULL, NULL, compareInts,
+                               MAP_BACKEND_SKIP_LIST, sizeof(int), sizeof(int));
+  for (int key = 0; key < 1000; key++) {
+    mapPut(plain, &key, &key);
+    mapPut(pooled, &key, &key);
+  }
+  for (int key = 0; key < 1000; key += 2) {
+    mapRemove(plain, &key);
+    mapRemove(pooled, &key);
+  }
+
+  /* the plain map calls malloc and free for each node, the pooled map
+   * calls malloc once per slab and keeps its slabs until it's cleared */
+  PoolStats plain_stats, pooled_stats;
+  mapGetAllocatorStats(plain, &plain_stats);
+  mapGetAllocatorStats(pooled, &pooled_stats);
+  CHECK_WITH_CLEANUP(plain_stats.allocations, 1000, DESTROY_STATS_MAPS);
+  CHECK_WITH_CLEANUP(plain_stats.releases, 500, DESTROY_STATS_MAPS);
+  CHECK_WITH_CLEANUP(plain_stats.system_allocations, 1000, DESTROY_STATS_MAPS);
+  CHECK_WITH_CLEANUP(plain_stats.system_releases, 500, DESTROY_STATS_MAPS);
+  CHECK_WITH_CLEANUP(pooled_stats.allocations, 1000, DESTROY_STATS_MAPS);
+  CHECK_WITH_CLEANUP(pooled_stats.releases, 500, DESTROY_STATS_MAPS);
+  CHECK_WITH_CLEANUP(pooled_stats.system_allocations * 10 < plain_stats.system_allocations, true,
+                     DESTROY_STATS_MAPS);
+  CHECK_WITH_CLEANUP(pooled_stats.system_releases, 0, DESTROY_STATS_MAPS);
+
+  mapClear(pooled);
+  mapGetAllocatorStats(pooled, &pooled_stats);
+  CHECK_WITH_CLEANUP(pooled_stats.releases, 1000, DESTROY_STATS_MAPS);
+  CHECK_WITH_CLEANUP(pooled_stats.system_releases, pooled_stats.system_allocations,
+                     DESTROY_STATS_MAPS);
+  CHECK_WITH_CLEANUP(mapGetAllocatorStats(NULL, &pooled_stats), MAP_NULL_ARGUMENT,
+                     DESTROY_STATS_MAPS);
+  DESTROY_STATS_MAPS;
+  return true;
+}
+#undef DESTROY_STATS_MAPS
+
+/* a typed int map keeps its pairs sorted by key, whatever order they're put in */
+bool testIntMap() {
+  IntIntMap map = intIntMapCreate();
+  for (int i = 0; i < 20; i++) {
+    int key = (i * 7) % 20;     /* every key from 0 to 19, out of order */
+    intIntMapPut(map, key, key * 10);
+  }
+  CHECK_WITH_CLEANUP(intIntMapGetSize(map), 20, intIntMapDestroy(map));
+  int expected_key = 0;
+  INT_MAP_FOREACH(IntIntMapEntry, entry, map) {
+    CHECK_WITH_CLEANUP(entry->key, expected_key, intIntMapDestroy(map));
+    CHECK_WITH_CLEANUP(entry->data, expected_key * 10, intIntMapDestroy(map));
+    expected_key++;
+  }
+
+  /* putting an existing key replaces its value */
+  CHECK_WITH_CLEANUP(intIntMapPut(map, 5, -5), MAP_SUCCESS, intIntMapDestroy(map));
+  CHECK_WITH_CLEANUP(intIntMapGetSize(map), 20, intIntMapDestroy(map));
+  CHECK_WITH_CLEANUP(*intIntMapGet(map, 5), -5, intIntMapDestroy(map));
+  CHECK_WITH_CLEANUP(intIntMapContains(map, 100), false, intIntMapDestroy(map));
+  CHECK_WITH_CLEANUP(intIntMapGet(map, 100), NULL, intIntMapDestroy(map));
+
+  /* the copy doesn't change with the map */
+  IntIntMap copy = intIntMapCopy(map);
+#define DESTROY_INT_MAPS do { intIntMapDestroy(map); intIntMapDestroy(copy); } while(0)
+  for (int key = 1; key < 20; key += 2) {
+    CHECK_WITH_CLEANUP(intIntMapRemove(map, key), MAP_SUCCESS, DESTROY_INT_MAPS);
+  }
+  CHECK_WITH_CLEANUP(intIntMapRemove(map, 1), MAP_ITEM_DOES_NOT_EXIST, DESTROY_INT_MAPS);
+  CHECK_WITH_CLEANUP(intIntMapGetSize(map), 10, DESTROY_INT_MAPS);
+  CHECK_WITH_CLEANUP(intIntMapGetSize(copy), 20, DESTROY_INT_MAPS);
+  CHECK_WITH_CLEANUP(intIntMapContains(copy, 5), true, DESTROY_INT_MAPS);
+  CHECK_WITH_CLEANUP(*intIntMapGet(copy, 5), -5, DESTROY_INT_MAPS);
+  const IntIntMapEntry *entries = intIntMapGetEntries(map);
+  for (int i = 0; i < intIntMapGetSize(map); i++) {
+    CHECK_WITH_CLEANUP(entries[i].key, i * 2, DESTROY_INT_MAPS);
+  }
+
+  DESTROY_INT_MAPS;
+#undef DESTROY_INT_MAPS
+  return true;
+}
+
+/* the same votes give the same results one by one and in a batch */
+bool testAddVotesMatchesAddVote() {
+  Eurovision eurovision = setupEurovision();
+  Eurovision batch = setupEurovision();
+  setupEurovisionStates(eurovision);
+  setupEurovisionStates(batch);
+
+  VoteDelta deltas[64];
+  unsigned int seed = 7;
+  for (int i = 0; i < 64; i++) {
+    seed = seed * 1103515245u + 12345u;
+    int giver = (seed >> 8) % 16;
+    int taker = (seed >> 12) % 16;
+    if (taker == giver) taker = (giver + 1) % 16;
+    int count = (int)((seed >> 16) % 9) - 2;    /* some of the deltas remove votes */
+    deltas[i] = (VoteDelta){ .stateGiver = giver, .stateTaker = taker, .count = count };
+    giveVotes(eurovision, giver, taker, count);
+  }
+  CHECK(eurovisionAddVotes(batch, deltas, 64), EUROVISION_SUCCESS);
+  setupEurovisionJudges(eurovision);
+  setupEurovisionJudges(batch);
+
+  List single_results[3] = { eurovisionRunContest(eurovision, 40), eurovisionRunAudienceFavorite(eurovision),
+                             eurovisionRunGetFriendlyStates(eurovision) };
+  List batch_results[3] = { eurovisionRunContest(batch, 40), eurovisionRunAudienceFavorite(batch),
+                            eurovisionRunGetFriendlyStates(batch) };
+  bool same = true;
+  for (int i = 0; i < 3; i++) {
+    same = same && sameLists(single_results[i], batch_results[i]);
+    listDestroy(single_results[i]);
+    listDestroy(batch_results[i]);
+  }
+  CHECK(same, true);
+
+  eurovisionDestroy(eurovision);
+  eurovisionDestroy(batch);
+  return true;
+}
+
+/* IDs that differ only in their high bits rank the same as consecutive IDs */
+bool testSpreadStateIds() {
+  Eurovision eurovision = setupEurovision();
+  Eurovision spread = setupEurovision();
+  setupManyStates(eurovision, 600, 1);
+  setupManyStates(spread, 600, 16384);
+
+  List contest = eurovisionRunContest(eurovision, 100);
+  List favorite = eurovisionRunAudienceFavorite(eurovision);
+  List spread_contest = eurovisionRunContest(spread, 100);
+  List spread_favorite = eurovisionRunAudienceFavorite(spread);
+  bool same = listGetSize(contest) == 600 && sameLists(contest, spread_contest) &&
+              sameLists(favorite, spread_favorite);
+  listDestroy(contest);
+  listDestroy(favorite);
+  listDestroy(spread_contest);
+  listDestroy(spread_favorite);
+  eurovisionDestroy(spread);
+  CHECK(same, true);
+
+  eurovisionDestroy(eurovision);
+  return true;
+}
+
+bool testRunContestSweep() {
+  Eurovision eurovision = setupEurovision();
+  setupEurovisionStates(eurovision);
+  setupEurovisionJudges(eurovision);
+  setupEurovisionVotes2(eurovision);
+
+  int percents[] = { 0, 40, 75, 100 };
+  int invalid_percents[] = { 40, 101 };
+  CHECK(eurovisionRunContestSweep(NULL, percents, 4), NULL);
+  CHECK(eurovisionRunContestSweep(eurovision, NULL, 4), NULL);
+  CHECK(eurovisionRunContestSweep(eurovision, invalid_percents, 2), NULL);
+
+  /* each ranking of the sweep is the same as running the contest with its percent */
+  List *rankings = eurovisionRunContestSweep(eurovision, percents, 4);
+  CHECK((rankings == NULL), false);
+  bool same = true;
+  for (int i = 0; i < 4; i++) {
+    List ranking = eurovisionRunContest(eurovision, percents[i]);
+    same = same && sameLists(rankings[i], ranking);
+    listDestroy(ranking);
+    listDestroy(rankings[i]);
+  }
+  free(rankings);
+  CHECK(same, true);
+
+  eurovisionDestroy(eurovision);
+  return true;
+}
+
+bool testRunContestCache() {
+  Eurovision eurovision = setupEurovision();
+  setupEurovisionStates(eurovision);
+  setupEurovisionJudges(eurovision);
+  setupEurovisionVotes2(eurovision);
+
+  /* repeated queries give the same results, each in a list of its own */
+  List first = eurovisionRunContest(eurovision, 40);
+  List second = eurovisionRunContest(eurovision, 40);
+  List podium = eurovisionRunContestTopK(eurovision, 40, 3);
+  List friendlies = eurovisionRunGetFriendlyStates(eurovision);
+  List friendlies_again = eurovisionRunGetFriendlyStates(eurovision);
+  bool correct = first != second && sameLists(first, second) && listGetSize(podium) == 3 &&
+                 friendlies != friendlies_again && sameLists(friendlies, friendlies_again);
+  char *expected = (char*)listGetFirst(first);
+  LIST_FOREACH(char*, name, podium) {
+    correct = correct && strcmp(name, expected) == 0;
+    expected = (char*)listGetNext(first);
+  }
+  listDestroy(first);
+  listDestroy(second);
+  listDestroy(podium);
+  listDestroy(friendlies);
+  listDestroy(friendlies_again);
+  CHECK(correct, true);
+
+  /* after a change the results are computed again */
+  CHECK(eurovisionRemoveState(eurovision, 10), EUROVISION_SUCCESS);
+  List ranking = eurovisionRunContest(eurovision, 40);
+  correct = listGetSize(ranking) == 15;
+  LIST_FOREACH(char*, name, ranking) {
+    correct = correct && strcmp(name, "united kingdom") != 0;
+  }
+  listDestroy(ranking);
+  CHECK(correct, true);
+
+  /* malta and croatia vote for each other, until croatia changes its favorite */
+  friendlies = eurovisionRunGetFriendlyStates(eurovision);
+  correct = listGetSize(friendlies) == 2;
+  listDestroy(friendlies);
+  CHECK(correct, true);
+  for (int i = 0; i < 30; i++) {
+    eurovisionAddVote(eurovision, 2, 15);
+  }
+  friendlies = eurovisionRunGetFriendlyStates(eurovision);
+  correct = listGetSize(friendlies) == 1 &&
+            strcmp((char*)listGetFirst(friendlies), "moldova - russia") == 0;
+  listDestroy(friendlies);
+  CHECK(correct, true);
+
+  eurovisionDestroy(eurovision);
+  return true;
+}
+
+bool testClone() {
+  Eurovision eurovision = setupEurovision();
+  setupEurovisionStates(eurovision);
+  setupEurovisionJudges(eurovision);
+  setupEurovisionVotes2(eurovision);
+
+  /* a clone gives the same results */
+  Eurovision clone = eurovisionClone(eurovision);
+  List ranking = eurovisionRunContest(eurovision, 40);
+  List clone_ranking = eurovisionRunContest(clone, 40);
+  bool correct = sameLists(ranking, clone_ranking);
+  listDestroy(clone_ranking);
+  CHECK(correct, true);
+
+  /* changing the clone doesn't change the original */
+  CHECK(eurovisionRemoveJudge(clone, 0), EUROVISION_SUCCESS);
+  CHECK(eurovisionRemoveState(clone, 10), EUROVISION_SUCCESS);
+  for (int i = 0; i < 30; i++) {
+    eurovisionAddVote(clone, 2, 15);
+  }
+  List original_ranking = eurovisionRunContest(eurovision, 40);
+  clone_ranking = eurovisionRunContest(clone, 40);
+  correct = sameLists(ranking, original_ranking) && listGetSize(clone_ranking) == 15;
+  listDestroy(original_ranking);
+  listDestroy(clone_ranking);
+  CHECK(correct, true);
+  CHECK(eurovisionRemoveJudge(eurovision, 0), EUROVISION_SUCCESS);
+  CHECK(eurovisionRemoveJudge(clone, 0), EUROVISION_JUDGE_NOT_EXIST);
+
+  /* the clone outlives the original (and so does a clone of the clone) */
+  Eurovision second_clone = eurovisionClone(clone);
+  eurovisionDestroy(eurovision);
+  List friendlies = eurovisionRunGetFriendlyStates(clone);
+  correct = listGetSize(friendlies) == 1 &&
+            strcmp((char*)listGetFirst(friendlies), "moldova - russia") == 0;
+  listDestroy(friendlies);
+  CHECK(correct, true);
+  eurovisionDestroy(clone);
+  clone_ranking = eurovisionRunContest(second_clone, 40);
+  correct = listGetSize(clone_ranking) == 15;
+  listDestroy(clone_ranking);
+  CHECK(correct, true);
+
+  listDestroy(ranking);
+  eurovisionDestroy(second_clone);
+  return true;
+}
+
+/* 200 states and a judge, for comparing tallies with different thread counts */
+static Eurovision setupThreadsEurovision() {
+  Eurovision eurovision = setupEurovision();
+  setupManyStates(eurovision, 200, 1);
+  int *results = makeJudgeResults(5, 17, 40, 3, 99, 120, 7, 8, 150, 9);
+  eurovisionAddJudge(eurovision, 1, "judge", results);
+  free(results);
+  return eurovision;
+}
+
+bool testRunContestThreads() {
+  Eurovision eurovision = setupThreadsEurovision();
+  Eurovision threaded_eurovision = setupThreadsEurovision();
+  CHECK(eurovisionSetThreadCount(NULL, 4), EUROVISION_NULL_ARGUMENT);
+  CHECK(eurovisionSetThreadCount(threaded_eurovision, 4), EUROVISION_SUCCESS);
+
+  List serial = eurovisionRunContest(eurovision, 60);
+  List serial_favorite = eurovisionRunAudienceFavorite(eurovision);
+  List threaded = eurovisionRunContest(threaded_eurovision, 60);
+  List threaded_favorite = eurovisionRunAudienceFavorite(threaded_eurovision);
+  bool same = sameLists(serial, threaded) && sameLists(serial_favorite, threaded_favorite);
+  listDestroy(threaded);
+  listDestroy(threaded_favorite);
+
+  /* changing the thread count keeps the results */
+  CHECK(eurovisionSetThreadCount(eurovision, 4), EUROVISION_SUCCESS);
+  threaded = eurovisionRunContest(eurovision, 60);
+  same = same && sameLists(serial, threaded);
+  listDestroy(threaded);
+  listDestroy(serial);
+  listDestroy(serial_favorite);
+
+  /* the threads are kept for the next tallies, and a clone gets threads of its own */
+  CHECK(eurovisionSetThreadCount(eurovision, 1), EUROVISION_SUCCESS);
+  Eurovision threaded_clone = eurovisionClone(threaded_eurovision);
+  for (int taker = 1; taker <= 3; taker++) {
+    giveVotes(eurovision, 0, taker, 30);
+    giveVotes(threaded_eurovision, 0, taker, 30);
+    giveVotes(threaded_clone, 0, taker, 30);
+    serial = eurovisionRunContest(eurovision, 60);
+    threaded = eurovisionRunContest(threaded_eurovision, 60);
+    List cloned = eurovisionRunContest(threaded_clone, 60);
+    same = same && sameLists(serial, threaded) && sameLists(serial, cloned);
+    listDestroy(serial);
+    listDestroy(threaded);
+    listDestroy(cloned);
+  }
+  eurovisionDestroy(threaded_clone);
+  eurovisionDestroy(threaded_eurovision);
+  CHECK(same, true);
+
+  eurovisionDestroy(eurovision);
+  return true;
+}
+
+#define QUERY_THREADS 4
+
+/* the results one thread got from querying a shared eurovision */
+typedef struct queryResults_t {
+  Eurovision eurovision;
+  List contest;
+  List favorite;
+  List friendlies;
+} QueryResults;
+
+static void *runQueries(void *arg) {
+  QueryResults *results = arg;
+  results->contest = eurovisionRunContest(results->eurovision, 60);
+  results->favorite = eurovisionRunAudienceFavorite(results->eurovision);
+  results->friendlies = eurovisionRunGetFriendlyStates(results->eurovision);
+  return NULL;
+}
+
+/* several threads querying one eurovision share its results and get the same lists */
+bool testConcurrentQueries() {
+  Eurovision eurovision = setupThreadsEurovision();
+  Eurovision reference = setupThreadsEurovision();
+
+  pthread_t threads[QUERY_THREADS];
+  QueryResults results[QUERY_THREADS];
+  for (int i = 0; i < QUERY_THREADS; i++) {
+    results[i] = (QueryResults){ .eurovision = eurovision };
+    pthread_create(&threads[i], NULL, runQueries, &results[i]);
+  }
+  for (int i = 0; i < QUERY_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  List contest = eurovisionRunContest(reference, 60);
+  List favorite = eurovisionRunAudienceFavorite(reference);
+  List friendlies = eurovisionRunGetFriendlyStates(reference);
+  bool same = true;
+  for (int i = 0; i < QUERY_THREADS; i++) {
+    same = same && sameLists(contest, results[i].contest) &&
+           sameLists(favorite, results[i].favorite) && sameLists(friendlies, results[i].friendlies);
+    listDestroy(results[i].contest);
+    listDestroy(results[i].favorite);
+    listDestroy(results[i].friendlies);
+  }
+  listDestroy(contest);
+  listDestroy(favorite);
+  listDestroy(friendlies);
+  eurovisionDestroy(reference);
+  CHECK(same, true);
+
+  eurovisionDestroy(eurovision);
+  return true;
+}
+
 bool testRunAudienceFavorite() {
   Eurovision eurovision = setupEurovision();
   setupEurovisionStates(eurovision);
@@ -7,8 +7,22 @@ bool testRemoveState();
 bool testAddJudge();
 bool testRemoveJudge();
 bool testAddVote();
+bool testAddVotes();
 bool testRemoveVote();
+bool testRemoveVoteReranks();
 bool testRunContest();
+bool testRunContestTopK();
+bool testRunContestExactTie();
+bool testMapAllocatorStats();
+bool testIntMap();
+bool testAddVotesMatchesAddVote();
+bool testSpreadStateIds();
+bool testRunContestSweep();
+bool testRunContestCache();
+bool testClone();
+bool testGetStandings();
+bool testRunContestThreads();
+bool testConcurrentQueries();
 bool testRunAudienceFavorite();
 bool testRunGetFriendlyStates();
 
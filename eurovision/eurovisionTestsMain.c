@@ -17,8 +17,22 @@ int main(int argc, char *argv[]) {
     TEST(testAddJudge)
     TEST(testRemoveJudge)
     TEST(testAddVote)
+    TEST(testAddVotes)
     TEST(testRemoveVote)
+    TEST(testRemoveVoteReranks)
     TEST(testRunContest)
+    TEST(testRunContestTopK)
+    TEST(testRunContestExactTie)
+    TEST(testMapAllocatorStats)
+    TEST(testIntMap)
+    TEST(testAddVotesMatchesAddVote)
+    TEST(testSpreadStateIds)
+    TEST(testRunContestSweep)
+    TEST(testRunContestCache)
+    TEST(testClone)
+    TEST(testGetStandings)
+    TEST(testRunContestThreads)
+    TEST(testConcurrentQueries)
     TEST(testRunAudienceFavorite)
     TEST(testRunGetFriendlyStates)
     return 0;
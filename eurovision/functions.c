@@ -2,13 +2,178 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
+#include <pthread.h>
 #include "functions.h"
 
-struct statePoints_t {
-    int id;
-    double points;
+/** open addressing hash table from state IDs to StatePoints elements */
+struct pointIndex_t {
+    int capacity;                   // a power of 2, at least twice the number of states
+    int shift;                      // 32 - log2(capacity), keeps the top bits of a hash
+    StatePoints **slots;            // NULL for an empty slot
 };
 
+/** multiplier for hashing state IDs (Knuth's multiplicative hashing, a 32 bit hash) */
+#define POINT_INDEX_HASH_MULTIPLIER 2654435769u
+
+/** key of a friendly pair: the pair's string is "{first_name} - {second_name}" */
+typedef struct friendlyPairKey_t {
+    const char *first_name;     // the names belong to the states' data
+    const char *second_name;
+    int smaller_id;             // tells apart pairs with the same names
+} *FriendlyPairKey;
+
+/** set of friendly pairs (key = FriendlyPairKey, value = the bigger ID of the pair) */
+struct friendlyPairs_t {
+    Map pairs;
+    bool valid;                 // false if an update failed, and the set must be rebuilt
+};
+
+/** the part of an audience tally done by one thread */
+typedef struct audienceTally_t {
+    PointIndex points_index;    // shared by all the threads, only read
+    StateData *givers;          // the givers this thread tallies
+    int num_of_givers;
+    int *slot_points;           // the points of the state in each slot of the index, from these givers
+} *AudienceTally;
+
+/** threads waiting for the parts of an audience tally */
+struct tallyPool_t {
+    int thread_count;           // number of parts a tally is split into
+    pthread_t *workers;         // the started threads (the calling thread of a tally is the last one)
+    int num_of_workers;
+    pthread_mutex_t lock;       // guards the fields below
+    pthread_cond_t work_ready;  // signaled when there are parts to take, or the pool is stopping
+    pthread_cond_t work_done;   // signaled when the last part of a tally is done
+    AudienceTally tallies;      // the parts of the current tally
+    int num_of_tallies;
+    int next_tally;             // the first part no thread took yet
+    int pending;                // number of parts that aren't done yet
+    bool stopping;
+};
+
+/***
+ * Tallies the points the givers of an audience tally give
+ * @param tally the part of the tally to do
+ */
+static void audienceTallyRun(AudienceTally tally);
+
+/***
+ * Takes parts of the pool's tallies and does them until the pool stops (the thread function of a pool)
+ * @param pool a TallyPool
+ * @return NULL
+ */
+static void *tallyPoolWork(void *pool);
+
+/***
+ * Does the parts of a tally with the pool's threads and the calling thread, and waits for all of them
+ * @param pool the pool
+ * @param tallies the parts of the tally
+ * @param num_of_tallies number of parts
+ */
+static void tallyPoolRun(TallyPool pool, AudienceTally tallies, int num_of_tallies);
+
+/***
+ * Tallies the audience points by splitting the givers between the threads of a pool,
+ * and adds the points to the StatePoints elements in the index
+ * @param states states map that contains the givers
+ * @param points_index index of the StatePoints elements of all the states
+ * @param num_of_givers number of states in the map
+ * @param pool the threads to tally with
+ * @param thread_count number of parts to split the givers into
+ * @return false if an allocation failed, true otherwise
+ */
+static bool tallyAudienceInThreads(Map states, PointIndex points_index, int num_of_givers,
+                                   TallyPool pool, int thread_count);
+
+/***
+ * Create an empty point index with room for a given number of states
+ * @param num_of_states number of states the index will hold
+ * @return pointer to the new index, NULL if an allocation failed
+ */
+static PointIndex pointIndexCreate(int num_of_states);
+
+/***
+ * Add a StatePoints element to a point index
+ * @param index the index to add to (must have room for the element)
+ * @param point_data the element to add
+ */
+static void pointIndexAdd(PointIndex index, StatePoints *point_data);
+
+/***
+ * Get the slot of a state in a point index
+ * @param index the index
+ * @param id the state's ID
+ * @return the index of the state's slot, or of the empty slot it should be in
+ */
+static int pointIndexFindSlot(PointIndex index, int id);
+
+/***
+ * Checks the states of a vote (the same checks for a single vote and for a batch)
+ * @param states states map that should contain the states
+ * @param state_giver the state that gives the votes
+ * @param state_taker the state that gets the votes
+ * @param giver_data state_giver's data, if it's already known (NULL otherwise).
+ *      If the check succeeds it's set to state_giver's data.
+ * @param taker_data if the check succeeds it's set to state_taker's data
+ * @return
+ *      EUROVISION_INVALID_ID if state_giver or state_taker less than 0
+ *      EUROVISION_STATE_NOT_EXIST if one of the states not in states map
+ *      EUROVISION_SAME_STATE if state_giver & state_taker is the same state
+ *      EUROVISION_SUCCESS otherwise
+ */
+static EurovisionResult checkVote(Map states, int state_giver, int state_taker,
+                                  StateData *giver_data, StateData *taker_data);
+
+/***
+ * Changes the number of votes a state gives another state,
+ * and updates the givers of the state that gets the votes (see stateGetGivers)
+ * @param votes state_giver's votes
+ * @param state_giver the state that gives the votes
+ * @param state_taker the state that gets the votes
+ * @param taker_data state_taker's data
+ * @param difference number of votes to add (negative to remove votes)
+ * @return VOTES_OUT_OF_MEMORY if an allocation failed (nothing is changed), VOTES_SUCCESS otherwise
+ */
+static VotesResult changeVotes(Votes votes, int state_giver, int state_taker, StateData taker_data,
+                               int difference);
+
+/** a delta of a batch, with the data of its states (found when the delta is checked) */
+typedef struct checkedDelta_t {
+    const VoteDelta *delta;
+    StateData giver_data;
+    StateData taker_data;
+} CheckedDelta;
+
+/***
+ * compare function for sorting the checked deltas of a batch by their state_giver
+ * (deltas of the same state_giver keep their order in the batch)
+ */
+static int compareDeltasByGiver(const void *delta1, const void *delta2);
+
+/***
+ * Makes the key of the friendly pair of two states (in either order)
+ * @param state_id1 ID of one of the states
+ * @param data1 the data of that state
+ * @param state_id2 ID of the other state
+ * @param data2 the data of the other state
+ * @return the pair's key
+ */
+static struct friendlyPairKey_t makeFriendlyPairKey(int state_id1, StateData data1,
+                                                    int state_id2, StateData data2);
+
+/***
+ * compare function for the keys of friendly pairs: by the pairs' strings, then by the smaller IDs
+ */
+static int compareFriendlyPairKeys(MapKeyElement key1, MapKeyElement key2);
+
+/***
+ * Rebuilds the set of friendly pairs from the favorite states of all the states
+ * @param pairs the set of friendly pairs
+ * @param states states map
+ * @return false if an allocation failed (the set stays invalid), true otherwise
+ */
+static bool friendlyPairsRebuild(FriendlyPairs pairs, Map states);
+
 /*********************** EUROVISION HELP FUNCTIONS *******************************/
  bool isLowerCase(char c) {
     return ('a' <= c && c <= 'z');
@@ -47,161 +212,288 @@ void freeString(ListElement str) {
     free(str);
 }
 
-EurovisionResult eurovisionChangeVote(Map states, int state_giver,
+EurovisionResult eurovisionChangeVote(Map states, FriendlyPairs friendly_pairs, int state_giver,
                                       int state_taker, int difference) {
     /// PARAMETER CHECKS ///
-    if (states == NULL) return EUROVISION_NULL_ARGUMENT;
-    if (state_giver < 0 || state_taker < 0) return EUROVISION_INVALID_ID;       // ID not valid
-    if (!mapContains(states, &state_giver) || !mapContains(states, &state_taker)) {
-        return EUROVISION_STATE_NOT_EXIST;          // one of the given states doesn't exist
-    }
-    if (state_giver == state_taker) return EUROVISION_SAME_STATE;       // same states given
+    if (states == NULL || friendly_pairs == NULL) return EUROVISION_NULL_ARGUMENT;
+    StateData giver_data = NULL, taker_data = NULL;
+    EurovisionResult check_result = checkVote(states, state_giver, state_taker, &giver_data, &taker_data);
+    if (check_result != EUROVISION_SUCCESS) return check_result;
     /// PARAMETER CHECKS ///
 
-    // get current number of votes for state_taker in state_giver's votes map
-    StateData giver_data = mapGet(states, &state_giver);
-    assert(giver_data != NULL);
-    int *current_votes_num = mapGet(stateGetVotes(giver_data), &state_taker);
+    // state_giver's votes are about to change, it mustn't share them with a clone
+    if (!stateMakeWritable(giver_data)) return EUROVISION_OUT_OF_MEMORY;
+
+    // save state_giver's ranking before the change
+    Votes votes = stateGetVotes(giver_data);
+    int old_results[NUMBER_OF_RANKINGS];
+    getStateResults(votes, old_results);
+
+    // change the number of votes for state_taker in state_giver's votes
+    VotesResult result = changeVotes(votes, state_giver, state_taker, taker_data, difference);
+    if (result == VOTES_OUT_OF_MEMORY) return EUROVISION_OUT_OF_MEMORY;
+
+    // update the scoreboard with the places that changed in the ranking
+    int new_results[NUMBER_OF_RANKINGS];
+    getStateResults(votes, new_results);
+    scoreboardUpdateRanking(states, old_results, new_results);
 
-    if (current_votes_num == NULL) { // no votes
-        if (difference > 0) {
-            // add state_taker to state's vote map along with the number of votes
-            MapResult put_result = mapPut(stateGetVotes(giver_data), &state_taker, &difference);
-            if (put_result == MAP_OUT_OF_MEMORY) return EUROVISION_OUT_OF_MEMORY;
+    // the first place of the ranking is state_giver's favorite state
+    friendlyPairsUpdate(friendly_pairs, states, state_giver, giver_data, old_results[0]);
+
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult eurovisionChangeVotes(Map states, FriendlyPairs friendly_pairs,
+                                       const VoteDelta *deltas, size_t n) {
+    if (states == NULL || friendly_pairs == NULL || (deltas == NULL && n > 0)) return EUROVISION_NULL_ARGUMENT;
+    if (n == 0) return EUROVISION_SUCCESS;      // nothing to change
+
+    // sort the deltas by their state_giver
+    CheckedDelta *sorted = malloc(sizeof(*sorted) * n);
+    if (!sorted) return EUROVISION_OUT_OF_MEMORY;
+    for (size_t i = 0; i < n; i++) {
+        sorted[i].delta = &deltas[i];
+    }
+    qsort(sorted, n, sizeof(*sorted), compareDeltasByGiver);
+
+    /// PARAMETER CHECKS ///
+    // check all the deltas before changing anything, each state_giver is looked up once
+    // (the states' data is kept for applying the deltas)
+    StateData giver_data = NULL;
+    for (size_t i = 0; i < n; i++) {
+        if (i > 0 && sorted[i].delta->stateGiver != sorted[i - 1].delta->stateGiver) {
+            giver_data = NULL;      // new state_giver
+        }
+        EurovisionResult check_result = checkVote(states, sorted[i].delta->stateGiver,
+                                                  sorted[i].delta->stateTaker, &giver_data,
+                                                  &sorted[i].taker_data);
+        if (check_result != EUROVISION_SUCCESS) {
+            free(sorted);
+            return check_result;
+        }
+        sorted[i].giver_data = giver_data;
+    }
+    /// PARAMETER CHECKS ///
+
+    // apply the deltas of each state_giver together
+    size_t group_start = 0;
+    while (group_start < n) {
+        int state_giver = sorted[group_start].delta->stateGiver;
+        StateData data = sorted[group_start].giver_data;
+        if (!stateMakeWritable(data)) {
+            free(sorted);
+            return EUROVISION_OUT_OF_MEMORY;
+        }
+        Votes votes = stateGetVotes(data);
+
+        // save state_giver's ranking before the changes
+        int old_results[NUMBER_OF_RANKINGS];
+        getStateResults(votes, old_results);
+
+        // change the number of votes for each state_taker in state_giver's votes
+        VotesResult result = VOTES_SUCCESS;
+        size_t i = group_start;
+        for (; i < n && sorted[i].delta->stateGiver == state_giver && result == VOTES_SUCCESS; i++) {
+            result = changeVotes(votes, state_giver, sorted[i].delta->stateTaker, sorted[i].taker_data,
+                                 sorted[i].delta->count);
         }
-        // if difference <= 0 nothing is done (no votes added or removed)
-    } else {
-        // if there are votes for this state already:
-        (*current_votes_num) += difference;             // update the number of votes
-        if ((*current_votes_num) <= 0) {                // if, after the update, number of votes <= 0
-            mapRemove(stateGetVotes(giver_data), &state_taker); // remove the votes from the votes map
+
+        // update the scoreboard once for the whole group
+        int new_results[NUMBER_OF_RANKINGS];
+        getStateResults(votes, new_results);
+        scoreboardUpdateRanking(states, old_results, new_results);
+        friendlyPairsUpdate(friendly_pairs, states, state_giver, data, old_results[0]);
+
+        if (result == VOTES_OUT_OF_MEMORY) {
+            free(sorted);
+            return EUROVISION_OUT_OF_MEMORY;
         }
+
+        group_start = i;
     }
 
+    free(sorted);
+
     return EUROVISION_SUCCESS;
 }
 
-/***************************** POINTS LIST FUNCTIONS *****************************/
-ListElement copyStatePoints(ListElement element) {
-    if (element == NULL) return NULL;
+static EurovisionResult checkVote(Map states, int state_giver, int state_taker,
+                                  StateData *giver_data, StateData *taker_data) {
+    if (state_giver < 0 || state_taker < 0) return EUROVISION_INVALID_ID;       // ID not valid
 
-    StatePoints copy = malloc(sizeof(*copy));
-    if (copy == NULL) return NULL;
+    if (*giver_data == NULL) {
+        *giver_data = mapGet(states, &state_giver);
+    }
+    *taker_data = mapGet(states, &state_taker);
+    if (!*giver_data || !*taker_data) {
+        return EUROVISION_STATE_NOT_EXIST;          // one of the given states doesn't exist
+    }
 
-    StatePoints data = element;
-    copy->id = data->id;
-    copy->points = data->points;
+    if (state_giver == state_taker) return EUROVISION_SAME_STATE;       // same states given
 
-    return copy;
-}
-void freeStatePoints(ListElement element) {
-    free(element);
+    return EUROVISION_SUCCESS;
 }
-int compareStatePoints(ListElement element1, ListElement element2) {
-    // if state in element1 ranks higher than state in element2
-    // returns negative
-    // (therefore state1 < state2 in final list)
-    // else return positive (NEVER returns 0)
 
-    assert(element1 != NULL && element2 != NULL);
+static VotesResult changeVotes(Votes votes, int state_giver, int state_taker, StateData taker_data,
+                               int difference) {
+    // state_taker's givers are about to change as well
+    if (!stateMakeWritable(taker_data)) return VOTES_OUT_OF_MEMORY;
+
+    VotesResult result = votesChange(votes, state_taker, difference);
+    if (result != VOTES_SUCCESS) return result;
 
-    StatePoints data1 = element1;
-    StatePoints data2 = element2;
+    IntIntMap givers = stateGetGivers(taker_data);
+    int count = votesGetCount(votes, state_taker);
+    if (count == 0) {
+        intIntMapRemove(givers, state_giver);   // no votes left (may have had none before either)
+        return VOTES_SUCCESS;
+    }
 
-    if (data1->points == data2->points) {
-        return data1->id - data2->id;       // IDs are always different
+    if (intIntMapPut(givers, state_giver, count) != MAP_SUCCESS) {
+        votesChange(votes, state_taker, -difference);   // the count is positive, so this only removes votes
+        return VOTES_OUT_OF_MEMORY;
     }
-    return (data2->points > data1->points) ? 1 : -1;
+
+    return VOTES_SUCCESS;
 }
 
-List pointListCreate(Map states) {
-    assert(states != NULL);
+static int compareDeltasByGiver(const void *delta1, const void *delta2) {
+    const VoteDelta *data1 = ((const CheckedDelta *)delta1)->delta;
+    const VoteDelta *data2 = ((const CheckedDelta *)delta2)->delta;
 
-    List list = listCreate(copyStatePoints, freeStatePoints);
-    if (!list) return NULL;
+    if (data1->stateGiver != data2->stateGiver) {
+        return (data1->stateGiver < data2->stateGiver) ? -1 : 1;
+    }
 
-    MAP_FOREACH(int*, id, states) {
-        StatePoints data = malloc(sizeof(*data));
-        if (!data) {
-            listDestroy(list);
-            return NULL;
-        }
+    // same state_giver, keep the batch order (the pointers point into the same array)
+    return (data1 < data2) ? -1 : (data1 > data2);
+}
 
-        data->id = *id;
-        data->points = 0.0; // initialize to zero
+/***************************** POINT VECTOR FUNCTIONS *****************************/
+PointVector pointVectorCreateForStates(Map states, PointIndex *index) {
+    assert(states != NULL);
 
-        ListResult result = listInsertFirst(list, data);
-        freeStatePoints(data);
+    // one element for each state, allocated at once
+    PointVector vector = pointVectorCreate(mapGetSize(states));
+    if (!vector) return NULL;
+
+    StatePoints *points = pointVectorGetData(vector);
+    int i = 0;
+    MapIterator iterator;
+    MAP_FOREACH_ITERATOR(int*, id, states, iterator) {
+        points[i].id = *id;
+        points[i].points = 0;   // initialize to zero
+        i++;
+    }
 
-        if (result != LIST_SUCCESS) {
-            listDestroy(list);
+    if (index) {
+        // index the vector's elements by their IDs
+        *index = pointIndexCreate(i);
+        if (!*index) {
+            pointVectorDestroy(vector);
             return NULL;
         }
+        for (int j = 0; j < i; j++) {
+            pointIndexAdd(*index, &points[j]);
+        }
     }
 
-    return list;
+    return vector;
 }
 
-List convertVotesToList(Map votes) {
-    assert(votes != NULL);
+StatePoints *pointIndexGet(PointIndex index, int id) {
+    assert(index != NULL);
+    return index->slots[pointIndexFindSlot(index, id)];
+}
 
-    // Convert to points list first (using votes instead of points)
-    List list = pointListCreate(votes);     // IDs are set here
-    LIST_FOREACH(StatePoints, point_data, list) {
-        int* vote_count = mapGet(votes, &(point_data->id));
-        if (!vote_count) {
-            listDestroy(list);
-            return NULL;
-        }
-        point_data->points = *vote_count;      // number of votes is set here
+void pointIndexDestroy(PointIndex index) {
+    if (index) {
+        free(index->slots);
+        free(index);
+    }
+}
+
+static PointIndex pointIndexCreate(int num_of_states) {
+    PointIndex index = malloc(sizeof(*index));
+    if (!index) return NULL;
+
+    // keep the table at most half full so searches stay short
+    index->capacity = 1;
+    index->shift = 32;
+    while (index->capacity < 2 * num_of_states) {
+        index->capacity *= 2;
+        index->shift--;
     }
 
-    // Use list sort to sort based on vote counts
-    ListResult result = listSort(list, compareStatePoints);
-    if (result != LIST_SUCCESS) {
-        listDestroy(list);
+    index->slots = calloc(index->capacity, sizeof(*index->slots));
+    if (!index->slots) {
+        free(index);
         return NULL;
     }
 
-    return list;
+    return index;
 }
 
-int *getStateResults(List votes_list) {
-    assert(votes_list != NULL);
+static void pointIndexAdd(PointIndex index, StatePoints *point_data) {
+    int slot = pointIndexFindSlot(index, point_data->id);
+    assert(index->slots[slot] == NULL);     // IDs are unique
+    index->slots[slot] = point_data;
+}
+
+static int pointIndexFindSlot(PointIndex index, int id) {
+    // the slot is the top log2(capacity) bits of the hash, which depend on all the bits of the ID
+    // (the low bits only depend on the low bits of the ID, so IDs that differ only in
+    // their high bits would all get the same slot)
+    uint32_t hash = (uint32_t)id * (uint32_t)POINT_INDEX_HASH_MULTIPLIER;
+    uint32_t slot = (uint32_t)((uint64_t)hash >> index->shift);    // shift is 32 for a single slot
+
+    // capacity is a power of 2, so the mask keeps the probing in range
+    uint32_t mask = index->capacity - 1;
 
-    int votes_size = listGetSize(votes_list);
-    int len = (votes_size < NUMBER_OF_RANKINGS ? votes_size : NUMBER_OF_RANKINGS);
+    // linear probing until the state or an empty slot is found
+    while (index->slots[slot] != NULL && index->slots[slot]->id != id) {
+        slot = (slot + 1) & mask;
+    }
+
+    return (int)slot;
+}
+
+void getStateResults(Votes votes, int *state_results) {
+    assert(votes != NULL && state_results != NULL);
 
-    int *state_results = malloc(sizeof(int) * NUMBER_OF_RANKINGS);
-    if (!state_results) return NULL;        // allocation failed
+    const VoteEntry *ranking = votesGetRanking(votes);
+    int len = votesGetRankingSize(votes);
 
-    StatePoints ptr = listGetFirst(votes_list);
     for (int i = 0; i < len; i++) {
-        state_results[i] = ptr->id;
-        ptr = listGetNext(votes_list);
+        state_results[i] = ranking[i].taker;
     }
     // if state voted for less than 10, fill the rest NO_STATE
     for (int i = len; i < NUMBER_OF_RANKINGS; i++) {
         state_results[i] = NO_STATE;
     }
-
-    return state_results;
 }
 
-List convertToStringList(List final_results, Map states) {
+List convertToStringList(PointVector final_results, int count, Map states) {
     assert(final_results != NULL && states != NULL);
 
-    // Create a list of names of the sates that are in given list
+    // Create a list of names of the sates that are in given vector
     List state_names = listCreate(copyString, freeString);
-    LIST_FOREACH(StatePoints, point_data, final_results) {
-        int stateId = point_data->id;
+    if (!state_names) return NULL;
+
+    StatePoints *points = pointVectorGetData(final_results);
+    if (count > pointVectorGetSize(final_results)) {
+        count = pointVectorGetSize(final_results);
+    }
+    for (int i = 0; i < count; i++) {
+        int stateId = points[i].id;
         StateData data = mapGet(states, &stateId);
         if (!data) {
             listDestroy(state_names);
             return NULL;
         }
 
-        // Keep the same order they have in given list
+        // Keep the same order they have in given vector
         ListResult result = listInsertLast(state_names, stateGetName(data));
         if (result != LIST_SUCCESS) {
             listDestroy(state_names);
@@ -222,76 +514,277 @@ Ranking getRanking(int place) {
     return ranking[place];
 }
 
-void distributePoints(List points_list, const int *results) {
+void distributePoints(PointIndex points_index, const int *results) {
     // for each state in results
     for (int i=0; i < NUMBER_OF_RANKINGS; i++) {
         int state_id = results[i];          // ID of the state to give points to
         int points = getRanking(i);         // get points to give
 
-        // iterate on points list & find the state to give points to
-        LIST_FOREACH(StatePoints, point_data, points_list){
-            if (point_data->id == state_id) {
-                point_data->points += points;      // update the state's points
-            }
+        // find the state to give points to in the index
+        StatePoints *point_data = pointIndexGet(points_index, state_id);
+        if (point_data != NULL) {
+            point_data->points += points;   // update the state's points
         }
     }
 }
 
-List getAudiencePoints(Map states) {
-    // create an audience points list with all states
-    List audience_points = pointListCreate(states);
-    if (!audience_points) return NULL;
+TallyPool tallyPoolCreate(int thread_count) {
+    assert(thread_count > 1);
+    TallyPool pool = malloc(sizeof(*pool));
+    if (!pool) return NULL;
 
-    // distribute each states votes accordingly in audience_points
-    MAP_FOREACH(int*, state_giver, states) {
-        StateData giver_data = mapGet(states, state_giver);     // get the state's data
-        assert(giver_data != NULL);
+    pool->workers = malloc(sizeof(*pool->workers) * (thread_count - 1));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->work_ready, NULL) != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->work_done, NULL) != 0) {
+        pthread_cond_destroy(&pool->work_ready);
+        pthread_mutex_destroy(&pool->lock);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
 
-        // get the state's sorted vote list
-        List votes_list = convertVotesToList(stateGetVotes(giver_data));
-        if (!votes_list) {
-            listDestroy(audience_points);
-            return NULL;
+    pool->thread_count = thread_count;
+    pool->tallies = NULL;
+    pool->num_of_tallies = 0;
+    pool->next_tally = 0;
+    pool->pending = 0;
+    pool->stopping = false;
+
+    // a thread that can't be started only leaves more parts to the calling thread
+    pool->num_of_workers = 0;
+    for (int t = 0; t < thread_count - 1; t++) {
+        if (pthread_create(&pool->workers[pool->num_of_workers], NULL, tallyPoolWork, pool) == 0) {
+            pool->num_of_workers++;
         }
+    }
 
-        int *state_results = getStateResults(votes_list);
+    return pool;
+}
+
+void tallyPoolDestroy(TallyPool pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int t = 0; t < pool->num_of_workers; t++) {
+        pthread_join(pool->workers[t], NULL);
+    }
+
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
 
-        listDestroy(votes_list);        // deallocate votes_list
+int tallyPoolGetThreadCount(TallyPool pool) {
+    return pool ? pool->thread_count : 1;
+}
+
+PointVector getAudiencePoints(Map states, TallyPool pool) {
+    // create an audience point vector with all states
+    PointIndex points_index;
+    PointVector audience_points = pointVectorCreateForStates(states, &points_index);
+    if (!audience_points) return NULL;
 
-        if (!state_results) {
-            listDestroy(audience_points);
+    // use more threads only if each one gets enough givers
+    int num_of_givers = mapGetSize(states);
+    int thread_count = tallyPoolGetThreadCount(pool);
+    if (thread_count > num_of_givers / AUDIENCE_TALLY_MIN_GIVERS_PER_THREAD) {
+        thread_count = num_of_givers / AUDIENCE_TALLY_MIN_GIVERS_PER_THREAD;
+    }
+
+    if (thread_count > 1) {
+        bool success = tallyAudienceInThreads(states, points_index, num_of_givers, pool, thread_count);
+        pointIndexDestroy(points_index);
+        if (!success) {
+            pointVectorDestroy(audience_points);
             return NULL;
         }
+        return audience_points;
+    }
+
+    // distribute each states votes accordingly in audience_points
+    MapIterator iterator;
+    MAP_FOREACH_ITERATOR(int*, state_giver, states, iterator) {
+        StateData giver_data = mapIteratorGetData(&iterator);   // get the state's data
+        assert(giver_data != NULL);
+
+        // get the state's up to date ranking (no need to sort its votes)
+        int state_results[NUMBER_OF_RANKINGS];
+        getStateResults(stateGetVotes(giver_data), state_results);
 
         // distribute points to the states in state_results
         // (according to their order in the array)
-        distributePoints(audience_points, state_results);
-
-        free(state_results);   // deallocate the state_results array
+        distributePoints(points_index, state_results);
     }
 
+    pointIndexDestroy(points_index);
+
     return audience_points;
 }
 
-List getJudgesPoints(Map judges, Map states) {
-    List judge_points = pointListCreate(states);
-    if (!judges) return NULL;
+static void audienceTallyRun(AudienceTally data) {
+    PointIndex index = data->points_index;
+
+    for (int i = 0; i < data->num_of_givers; i++) {
+        // get the giver's up to date ranking
+        int state_results[NUMBER_OF_RANKINGS];
+        getStateResults(stateGetVotes(data->givers[i]), state_results);
+
+        // add the points to the slots of the ranked states (empty places have no slot)
+        for (int place = 0; place < NUMBER_OF_RANKINGS; place++) {
+            int slot = pointIndexFindSlot(index, state_results[place]);
+            if (index->slots[slot] != NULL) {
+                data->slot_points[slot] += getRanking(place);
+            }
+        }
+    }
+}
+
+static void *tallyPoolWork(void *pool_ptr) {
+    TallyPool pool = pool_ptr;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (!pool->stopping && pool->next_tally == pool->num_of_tallies) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->stopping) break;
+
+        // take the next part, and do it without holding the lock
+        AudienceTally tally = &pool->tallies[pool->next_tally++];
+        pthread_mutex_unlock(&pool->lock);
+        audienceTallyRun(tally);
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+static void tallyPoolRun(TallyPool pool, AudienceTally tallies, int num_of_tallies) {
+    pthread_mutex_lock(&pool->lock);
+    pool->tallies = tallies;
+    pool->num_of_tallies = num_of_tallies;
+    pool->next_tally = 0;
+    pool->pending = num_of_tallies;
+    pthread_cond_broadcast(&pool->work_ready);
+
+    // the calling thread takes parts as well, so they're all done even without workers
+    while (pool->next_tally < pool->num_of_tallies) {
+        AudienceTally tally = &pool->tallies[pool->next_tally++];
+        pthread_mutex_unlock(&pool->lock);
+        audienceTallyRun(tally);
+        pthread_mutex_lock(&pool->lock);
+        pool->pending--;
+    }
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+
+    // nothing is left for the workers to take
+    pool->tallies = NULL;
+    pool->num_of_tallies = 0;
+    pool->next_tally = 0;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static bool tallyAudienceInThreads(Map states, PointIndex points_index, int num_of_givers,
+                                   TallyPool pool, int thread_count) {
+    int capacity = points_index->capacity;
+    StateData *givers = malloc(sizeof(*givers) * num_of_givers);
+    struct audienceTally_t *tallies = malloc(sizeof(*tallies) * thread_count);
+    int *slot_points = calloc((size_t)capacity * thread_count, sizeof(*slot_points));
+    if (!givers || !tallies || !slot_points) {
+        free(givers);
+        free(tallies);
+        free(slot_points);
+        return false;
+    }
+
+    // collect the givers first, the map's iterator can't be shared between threads
+    int num_collected = 0;
+    MapIterator iterator;
+    MAP_FOREACH_ITERATOR(int *, state_giver, states, iterator) {
+        givers[num_collected++] = mapIteratorGetData(&iterator);
+    }
+    assert(num_collected == num_of_givers);
+
+    // give each thread a range of about the same number of givers, and its own points
+    for (int t = 0; t < thread_count; t++) {
+        int start = (int)((long long)num_of_givers * t / thread_count);
+        int end = (int)((long long)num_of_givers * (t + 1) / thread_count);
+        tallies[t].points_index = points_index;
+        tallies[t].givers = givers + start;
+        tallies[t].num_of_givers = end - start;
+        tallies[t].slot_points = slot_points + (size_t)capacity * t;
+    }
+
+    // the pool's threads (already running) and the calling thread take the ranges
+    tallyPoolRun(pool, tallies, thread_count);
+
+    // add up the points of all the threads (integers, so the order doesn't change the sum)
+    for (int slot = 0; slot < capacity; slot++) {
+        StatePoints *point_data = points_index->slots[slot];
+        if (point_data == NULL) continue;
+
+        int points = 0;
+        for (int t = 0; t < thread_count; t++) {
+            points += tallies[t].slot_points[slot];
+        }
+        point_data->points += points;
+    }
+
+    free(givers);
+    free(tallies);
+    free(slot_points);
+
+    return true;
+}
+
+PointVector getJudgesPoints(JudgeMap judges, Map states) {
+    PointIndex points_index;
+    PointVector judge_points = pointVectorCreateForStates(states, &points_index);
+    if (!judge_points) return NULL;
 
     // for each judge
-    MAP_FOREACH(int *, judge_id, judges) {
-        // get the judge's data
-        JudgeData judge_data = mapGet(judges, judge_id);
-        assert(judge_data != NULL);
+    INT_MAP_FOREACH(JudgeMapEntry, judge, judges) {
+        assert(judge->data != NULL);
 
         // distribute points to the states in judge_results
         // (according to their order in the array)
-        distributePoints(judge_points, judgeGetResults(judge_data));
+        distributePoints(points_index, judgeGetResults(judge->data));
     }
 
+    pointIndexDestroy(points_index);
+
     return judge_points;
 }
 
-void calculateFinalPoints(List audience_points, List judge_points,
+void calculateFinalPoints(PointVector audience_points, PointVector judge_points,
+                          PointVector final_points,
                           int num_of_states, int num_of_judges,
                           int audience_percent) {
     int judge_percent = 100 - audience_percent;
@@ -305,78 +798,135 @@ void calculateFinalPoints(List audience_points, List judge_points,
         num_of_states = 1;
     }
 
+    // The final points are
+    //   audience / num_of_states * audience_percent + judge / num_of_judges * judge_percent
+    // multiplied by num_of_states * num_of_judges (the same for all the states, so the ranking
+    // doesn't change), which leaves no division and keeps the points exact integers.
+    // Without judges only the audience part counts, multiplied by num_of_states.
+    int64_t audience_weight = (int64_t)audience_percent * (num_of_judges > 0 ? num_of_judges : 1);
+    int64_t judge_weight = (num_of_judges > 0) ? (int64_t)judge_percent * num_of_states : 0;
+
     // Iterate through the points each state got and calculate their final points
-    // If there are no states the point lists will be empty so the loop won't iterate
-    StatePoints judge_points_ptr = listGetFirst(judge_points);
-    LIST_FOREACH(StatePoints, point_data, audience_points) {
-        assert(judge_points_ptr != NULL);
-
-        // Divide each state's audience points by the number of states
-        point_data->points /= num_of_states;
-        // Multiply each state's audience points by audience percentage
-        point_data->points *= audience_percent;
-
-        // if there are judges we have to take the judge points into account
-        if (num_of_judges > 0) {
-            // Divide each state's judge points by the number of judges
-            judge_points_ptr->points /= num_of_judges;
-            // Multiply each state's judge points by audience percentage
-            judge_points_ptr->points *= judge_percent;
-
-            // Add judge points to audience points
-            point_data->points += judge_points_ptr->points;
-
-            // increment judge_points pointer
-            judge_points_ptr = listGetNext(judge_points);
-        }
+    // (the same state is in the same place in both vectors)
+    // If there are no states the point vectors will be empty so the loop won't iterate
+    int size = pointVectorGetSize(audience_points);
+    assert(size == pointVectorGetSize(judge_points) && size == pointVectorGetSize(final_points));
+    const StatePoints *audience = pointVectorGetData(audience_points);
+    const StatePoints *judge = pointVectorGetData(judge_points);
+    StatePoints *final = pointVectorGetData(final_points);
+#ifdef MAP_DEBUG_CHECKS
+    // checked in its own loop, so the combining loop below has no branches and can be vectorized
+    for (int i = 0; i < size; i++) {
+        assert(audience[i].id == judge[i].id);
+    }
+#endif
+    for (int i = 0; i < size; i++) {
+        final[i].id = audience[i].id;
+        final[i].points = audience[i].points * audience_weight + judge[i].points * judge_weight;
     }
 }
 
-/********************** FRIENDLY STATE FUNCTIONS ***********************/
-int stringCompare(void* str1, void* str2) {
-    return strcmp(str1, str2);  // lexicographical comparison
-}
-
-Map getStateFavorites(Map states) {
-    // create a map that matches each state to its most voted state
-    // (key = state ID, value = favorite state ID)
-    Map state_favorites = mapCreate(copyInt, copyInt,
-                                    freeInt, freeInt,
-                                    compareInts);
-    if (!state_favorites) return NULL;
-
-    // initialize the favorite states map
-    MAP_FOREACH(int*, stateId, states) {
-        // for each state
-        StateData state = mapGet(states, stateId);
-        if (!state) {
-            mapDestroy(state_favorites);
-            return NULL;
+/***************************** SCOREBOARD FUNCTIONS *****************************/
+void scoreboardApplyRanking(Map states, const int *results, int sign, bool from_judge) {
+    assert(states != NULL && results != NULL);
+
+    for (int i = 0; i < NUMBER_OF_RANKINGS; i++) {
+        int state_id = results[i];
+        if (state_id == NO_STATE) continue;     // empty place
+
+        StateData data = mapGet(states, &state_id);
+        assert(data != NULL);
+
+        if (from_judge) {
+            stateAddJudgePoints(data, sign * (int)getRanking(i));
+        } else {
+            stateAddAudiencePoints(data, sign * (int)getRanking(i));
         }
+    }
+}
 
-        // get the ID of the state's most voted state
-        int favState = stateGetFavorite(state);
+void scoreboardUpdateRanking(Map states, const int *old_results, const int *new_results) {
+    assert(states != NULL && old_results != NULL && new_results != NULL);
 
-        // insert the state along with it's most voted state to the favorite states map
-        MapResult result = mapPut(state_favorites, stateId, &favState);
-        if (result != MAP_SUCCESS) {
-            mapDestroy(state_favorites);
-            return NULL;
+    for (int i = 0; i < NUMBER_OF_RANKINGS; i++) {
+        int old_id = old_results[i], new_id = new_results[i];
+        if (old_id == new_id) continue;     // same state in this place
+
+        // the state that lost the place loses its points, the state that got it gets them
+        StateData old_data = mapGet(states, &old_id);
+        StateData new_data = mapGet(states, &new_id);
+        if (old_data) stateAddAudiencePoints(old_data, -(int)getRanking(i));
+        if (new_data) stateAddAudiencePoints(new_data, (int)getRanking(i));
+    }
+}
+
+PointVector getScoreboardPoints(Map states, bool from_judges) {
+    PointVector points_vector = pointVectorCreateForStates(states, NULL);
+    if (!points_vector) return NULL;
+
+    // set each state's points from its data (the vector is in the same order as the map)
+    StatePoints *points = pointVectorGetData(points_vector);
+    int i = 0;
+    MapIterator iterator;
+    MAP_FOREACH_ITERATOR(int *, state_id, states, iterator) {
+        StateData data = mapIteratorGetData(&iterator);
+        assert(data != NULL && points[i].id == *state_id);
+        points[i].points = from_judges ? stateGetJudgePoints(data) : stateGetAudiencePoints(data);
+        i++;
+    }
+
+    return points_vector;
+}
+
+/***************************** JUDGE INDEX FUNCTIONS *****************************/
+bool judgeIndexAdd(Map states, int judge_id, const int *results) {
+    assert(states != NULL && results != NULL);
+
+    if (!statesMakeWritable(states, results)) return false;
+
+    for (int place = 0; place < NUMBER_OF_RANKINGS; place++) {
+        int state_id = results[place];
+        StateData data = mapGet(states, &state_id);
+        assert(data != NULL);
+
+        if (intIntMapPut(stateGetJudges(data), judge_id, place) != MAP_SUCCESS) {
+            judgeIndexRemove(states, judge_id, results);    // undo the places added so far
+            return false;
         }
     }
 
-    return state_favorites;
+    return true;
+}
+
+bool judgeIndexRemove(Map states, int judge_id, const int *results) {
+    assert(states != NULL && results != NULL);
+
+    if (!statesMakeWritable(states, results)) return false;
+
+    for (int place = 0; place < NUMBER_OF_RANKINGS; place++) {
+        int state_id = results[place];
+        StateData data = mapGet(states, &state_id);
+        assert(data != NULL);
+
+        intIntMapRemove(stateGetJudges(data), judge_id);    // may be missing if it was never added
+    }
+
+    return true;
 }
 
-bool statesAreFriendly(const int *stateId1, const int *favState1,
-                       const int *stateId2, const int *favState2) {
-    // if received NULL pointer return false
-    if (!stateId1 || !favState1 || !stateId2 || !favState2) return false;
+bool statesMakeWritable(Map states, const int *results) {
+    assert(states != NULL && results != NULL);
+
+    for (int place = 0; place < NUMBER_OF_RANKINGS; place++) {
+        int state_id = results[place];
+        StateData data = mapGet(states, &state_id);
+        if (data && !stateMakeWritable(data)) return false;
+    }
 
-    // check if first state's most voted state is the second state and vice-versa
-    return (*stateId1 == *favState2 && *stateId2 == *favState1);
+    return true;
 }
 
+/********************** FRIENDLY STATE FUNCTIONS ***********************/
 char *getStatePair(StateData state1, StateData state2) {
     // get the states' names
     char *name1 = stateGetName(state1);
@@ -407,59 +957,163 @@ char *getStatePair(StateData state1, StateData state2) {
     return statePair;
 }
 
-List getFriendlyStates(Map states) {
+FriendlyPairs friendlyPairsCreate() {
+    FriendlyPairs pairs = malloc(sizeof(*pairs));
+    if (!pairs) return NULL;
+
+    // the keys and the bigger IDs are kept inline in pooled nodes
+    pairs->pairs = mapCreatePooled(NULL, NULL, NULL, NULL, compareFriendlyPairKeys,
+                                   MAP_BACKEND_SKIP_LIST, sizeof(struct friendlyPairKey_t), sizeof(int));
+    if (!pairs->pairs) {
+        free(pairs);
+        return NULL;
+    }
+    pairs->valid = true;    // there are no states yet, so there are no pairs
+
+    return pairs;
+}
+
+FriendlyPairs friendlyPairsCopy(FriendlyPairs pairs) {
+    if (!pairs) return NULL;
+
+    FriendlyPairs copy = malloc(sizeof(*copy));
+    if (!copy) return NULL;
+
+    // the keys point to the states' names, which all the copies of a state share
+    copy->pairs = mapCopy(pairs->pairs);
+    if (!copy->pairs) {
+        free(copy);
+        return NULL;
+    }
+    copy->valid = pairs->valid;
+
+    return copy;
+}
+
+void friendlyPairsDestroy(FriendlyPairs pairs) {
+    if (pairs) {
+        mapDestroy(pairs->pairs);
+        free(pairs);
+    }
+}
+
+void friendlyPairsUpdate(FriendlyPairs pairs, Map states, int state_id, StateData state_data,
+                         int old_favorite) {
+    assert(pairs != NULL && states != NULL && state_data != NULL);
+
+    int new_favorite = stateGetFavorite(state_data);
+    if (new_favorite == old_favorite || !pairs->valid) return;  // nothing changed, or rebuilt later
+
+    // the state and its old favorite aren't friendly anymore
+    StateData old_data = (old_favorite != NO_STATE) ? mapGet(states, &old_favorite) : NULL;
+    if (old_data && stateGetFavorite(old_data) == state_id) {
+        struct friendlyPairKey_t key = makeFriendlyPairKey(state_id, state_data, old_favorite, old_data);
+        mapRemove(pairs->pairs, &key);
+    }
+
+    // the state and its new favorite are friendly if the new favorite's favorite is the state
+    StateData new_data = (new_favorite != NO_STATE) ? mapGet(states, &new_favorite) : NULL;
+    if (new_data && stateGetFavorite(new_data) == state_id) {
+        struct friendlyPairKey_t key = makeFriendlyPairKey(state_id, state_data, new_favorite, new_data);
+        int bigger_id = (state_id > new_favorite) ? state_id : new_favorite;
+        if (mapPut(pairs->pairs, &key, &bigger_id) != MAP_SUCCESS) {
+            // the set is rebuilt from the states the next time it's listed
+            mapClear(pairs->pairs);
+            pairs->valid = false;
+        }
+    }
+}
+
+List friendlyPairsGetList(FriendlyPairs pairs, Map states) {
+    assert(pairs != NULL && states != NULL);
+
+    if (!pairs->valid && !friendlyPairsRebuild(pairs, states)) return NULL;
+
     // create empty string list
     List friendly_states = listCreate(copyString, freeString);
     if (!friendly_states) return NULL;  // allocation failed
 
-    // get state favorites map - key = state's ID, value = favorite state's ID
-    Map state_favorites = getStateFavorites(states);
-    if (!state_favorites) {
-        listDestroy(friendly_states);
-        return NULL;                    // allocation failed
-    }
-
-    // for each state in state favorites
-    MAP_FOREACH(int*, stateId, state_favorites) {
-        // get its favorite state's ID
-        int *favState1 = mapGet(state_favorites, stateId);
-        // get the ID of the favorite state's favorite state
-        int *stateId2 = favState1;
-        int *favState2 = mapGet(state_favorites, stateId2);
-
-        // check if the states are favorites of each other
-        // (outside function also checks if pointer are NULL)
-        if (statesAreFriendly(stateId, favState1, stateId2, favState2)) {
-            // if states are a pair get their data
-            StateData state1 = mapGet(states, stateId);
-            StateData state2 = mapGet(states, stateId2);
-
-            /// mark as if they have no favorite state **to prevent duplicates**
-            *favState1 = NO_STATE;
-            *favState2 = NO_STATE;
-
-            // create the string that contains the state names (ordered lexicographically)
-            char *statePair = getStatePair(state1, state2);
-            if (!statePair) {
-                mapDestroy(state_favorites);
-                listDestroy(friendly_states);
-                return NULL;            // allocation failed
-            }
+    // the pairs are ordered by their strings, so the list is sorted as well
+    MapIterator iterator;
+    MAP_FOREACH_ITERATOR(FriendlyPairKey, key, pairs->pairs, iterator) {
+        int *bigger_id = mapIteratorGetData(&iterator);
+        char *statePair = getStatePair(mapGet(states, &key->smaller_id), mapGet(states, bigger_id));
+        if (!statePair) {
+            listDestroy(friendly_states);
+            return NULL;            // allocation failed
+        }
 
-            // add the string to the list
-            ListResult result = listInsertLast(friendly_states, statePair);
+        // add the string to the list
+        ListResult result = listInsertLast(friendly_states, statePair);
 
-            free(statePair);        // deallocate the string with the state names
+        free(statePair);        // deallocate the string with the state names
 
-            if (result != LIST_SUCCESS) {
-                mapDestroy(state_favorites);
-                listDestroy(friendly_states);
-                return NULL;            // list insert failed
-            }
+        if (result != LIST_SUCCESS) {
+            listDestroy(friendly_states);
+            return NULL;            // list insert failed
         }
     }
 
-    mapDestroy(state_favorites);    // destroy state favorites map
-
     return friendly_states;
 }
+
+static struct friendlyPairKey_t makeFriendlyPairKey(int state_id1, StateData data1,
+                                                    int state_id2, StateData data2) {
+    char *name1 = stateGetName(data1);
+    char *name2 = stateGetName(data2);
+
+    // order the states' names lexicographically (the same as in getStatePair)
+    struct friendlyPairKey_t key = { .first_name = name2, .second_name = name1 };
+    if (strcmp(name1, name2) < 0) {
+        key.first_name = name1;
+        key.second_name = name2;
+    }
+    key.smaller_id = (state_id1 < state_id2) ? state_id1 : state_id2;
+
+    return key;
+}
+
+static int compareFriendlyPairKeys(MapKeyElement key1, MapKeyElement key2) {
+    FriendlyPairKey pair1 = key1, pair2 = key2;
+
+    // compare the strings "{first name} - {second name}" of the pairs without building them
+    const char *parts1[] = { pair1->first_name, EXTRA_CHARS, pair1->second_name };
+    const char *parts2[] = { pair2->first_name, EXTRA_CHARS, pair2->second_name };
+    int part1 = 0, part2 = 0;
+    const char *ptr1 = parts1[0], *ptr2 = parts2[0];
+    while (true) {
+        // move on to the next part of each string when its current part ends
+        while (*ptr1 == '\0' && part1 < 2) ptr1 = parts1[++part1];
+        while (*ptr2 == '\0' && part2 < 2) ptr2 = parts2[++part2];
+
+        if (*ptr1 != *ptr2) return (unsigned char)*ptr1 - (unsigned char)*ptr2;
+        if (*ptr1 == '\0') break;  // same strings
+        ptr1++;
+        ptr2++;
+    }
+
+    // pairs with the same names are different pairs of states
+    return compareInts(&pair1->smaller_id, &pair2->smaller_id);
+}
+
+static bool friendlyPairsRebuild(FriendlyPairs pairs, Map states) {
+    mapClear(pairs->pairs);
+
+    // add each state whose favorite's favorite is the state itself (once for each pair)
+    MapIterator iterator;
+    MAP_FOREACH_ITERATOR(int *, state_id, states, iterator) {
+        StateData data = mapIteratorGetData(&iterator);
+        int favorite = stateGetFavorite(data);
+        StateData favorite_data = (favorite > *state_id) ? mapGet(states, &favorite) : NULL;
+        if (favorite_data && stateGetFavorite(favorite_data) == *state_id) {
+            struct friendlyPairKey_t key = makeFriendlyPairKey(*state_id, data, favorite, favorite_data);
+            if (mapPut(pairs->pairs, &key, &favorite) != MAP_SUCCESS) {
+                mapClear(pairs->pairs);
+                return false;
+            }
+        }
+    }
+
+    pairs->valid = true;
+    return true;
+}
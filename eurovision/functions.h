@@ -5,6 +5,7 @@
 #include "eurovision.h"
 #include "state.h"
 #include "judge.h"
+#include "points.h"
 
 /*
  * These are included in judge.h:
@@ -31,6 +32,16 @@ typedef enum {
     FIRST_PLACE = 12
 } Ranking;
 
+/** minimal number of givers each thread tallies in a multithreaded audience tally
+ *  (fewer givers aren't worth the cost of handing them to a thread) */
+#define AUDIENCE_TALLY_MIN_GIVERS_PER_THREAD 32
+
+/** threads kept for the audience tallies of a eurovision (see getAudiencePoints) */
+typedef struct tallyPool_t *TallyPool;
+
+/** set of the friendly pairs of states (see FRIENDLY STATE FUNCTIONS) */
+typedef struct friendlyPairs_t *FriendlyPairs;
+
 /********************** EUROVISION HELP FUNCTIONS ***********************/
 /***
  * Check if a given character is a lower case alphabet letter
@@ -48,8 +59,7 @@ bool isValidName(const char* name);
 
 /***
  * copy function for integer elements that used in:
- * Judge/State/state_favorites Maps keysElements
- * and in votes/state_favorites Maps dataElements
+ * States Map keysElements
  * @param integer pointer for int element to copy
  * @return a pointer for the new int element
  */
@@ -57,16 +67,14 @@ void* copyInt(void* integer);
 
 /***
  * free function for integer elements that used in:
- * Judge/State/state_favorites Maps keysElements
- * and in votes/state_favorites Maps dataElements
+ * States Map keysElements
  * @param integer pointer for int element to free
  */
 void freeInt(void* integer);
 
 /***
  * compare function for integer elements that used in:
- * Judge/State/state_favorites Maps keysElements
- * and in votes/state_favorites Maps dataElements
+ * States Map keysElements
  * @param integer1 first integer to compare
  * @param integer2 second integer to compare
  * @return
@@ -92,83 +100,94 @@ void freeString(ListElement str);
 /***
  * Change the count of votes from stateGiver to stateTaker by a given difference
  * @param states states map that contains stateGiver & stateTaker
+ * @param friendly_pairs the friendly pairs, updated if state_giver's favorite state changed
  * @param state_giver the state that gives the votes
  * @param state_taker the state that gets the votes
  * @param difference number of votes to give to stateTaker
  * @return
- *      EUROVISION_NULL_ARGUMENT if states is NULL
+ *      EUROVISION_NULL_ARGUMENT if states or friendly_pairs is NULL
  *      EUROVISION_INVALID_ID if state_giver or state_taker less than 0
  *      EUROVISION_STATE_NOT_EXIST if one of the states not in states map
  *      EUROVISION_SAME_STATE if state_giver & state_taker is the same state
  *      EUROVISION_OUT_OF_MEMORY if memory allocation failed
  *      EUROVISION_SUCCESS if the votes was added
+ *  The scoreboard is updated if state_giver's ranking changed.
  */
-EurovisionResult eurovisionChangeVote(Map states, int state_giver,
+EurovisionResult eurovisionChangeVote(Map states, FriendlyPairs friendly_pairs, int state_giver,
                                       int state_taker, int difference);
 
-/********************** POINT LIST FUNCTIONS & STRUCTS ***********************
-* point List is a List of StatePoints for saving the points/votes of each state */
-
-/** struct for summing up the amount of points a state receives or gives */
-typedef struct statePoints_t *StatePoints;
-
 /***
- * copy function for StatePoints element
- * @param element pointer statePoints element to copy
- * @return pointer to the new statePoints element
+ * Change the counts of votes by a batch of differences.
+ * The deltas are grouped by their stateGiver, so each giver is looked up once
+ * and its ranking is updated on the scoreboard once.
+ * All the deltas are checked before any votes are changed: if one of them is invalid
+ * no votes are changed, and its error is returned (the deltas are checked by their
+ * stateGiver, and in their order in the array for the same stateGiver).
+ * @param states states map that contains the states in the deltas
+ * @param friendly_pairs the friendly pairs, updated if a stateGiver's favorite state changed
+ * @param deltas array of n differences (a count of 0 changes nothing)
+ * @param n number of deltas
+ * @return
+ *      EUROVISION_NULL_ARGUMENT if states or friendly_pairs is NULL, or if deltas is NULL and n isn't 0
+ *      EUROVISION_INVALID_ID if a stateGiver or a stateTaker is less than 0
+ *      EUROVISION_STATE_NOT_EXIST if one of the states not in states map
+ *      EUROVISION_SAME_STATE if a delta's stateGiver & stateTaker is the same state
+ *      EUROVISION_OUT_OF_MEMORY if memory allocation failed
+ *          (the deltas applied before the failure stay applied)
+ *      EUROVISION_SUCCESS if all the votes were changed
  */
-ListElement copyStatePoints(ListElement element);
+EurovisionResult eurovisionChangeVotes(Map states, FriendlyPairs friendly_pairs,
+                                       const VoteDelta *deltas, size_t n);
 
-/***
- * free function for StatePoints element
- * @param element statePoints element to free
- */
-void freeStatePoints(ListElement element);
+/********************** POINT VECTOR FUNCTIONS & STRUCTS ***********************
+* A point vector (see points.h) holds the points of each state in a contest */
+
+/** hash index from a state's ID to its StatePoints element in a point vector */
+typedef struct pointIndex_t *PointIndex;
 
 /***
- * compare function for StatePoints element
- * Note: compare function only returns positive or negative
- * (two StatePoints structs can't be equal because IDs are unique)
- * @param element1 pointer to the first statePoints element
- * @param element2 pointer to the second statePoints element
- * @return
- *   negative number if state in element1 ranks higher than state in element2
- *   positive number if state in element2 ranks higher than state in element1
+ * Create a point vector of all the states. Initializes points to zero
+ * @param states states map to create the point vector from
+ * @param index if not NULL, set to a new index of the vector's elements by ID
+ *   (the index is valid until the vector is sorted, and should be
+ *   deallocated using pointIndexDestroy)
+ * @return pointer to the new point vector, NULL if an allocation failed
  */
-int compareStatePoints(ListElement element1, ListElement element2);
+PointVector pointVectorCreateForStates(Map states, PointIndex *index);
 
 /***
- * Create StatePoints List. Initializes points to zero
- * @param states states/votes map to create the StatePoints list from
- * @return pointer to the new statePoints list
+ * Get the StatePoints element of a state from a point vector index
+ * @param index the index of the point vector
+ * @param id the state's ID
+ * @return the state's StatePoints element, or NULL if the state isn't in the vector
  */
-List pointListCreate(Map states);
+StatePoints *pointIndexGet(PointIndex index, int id);
 
 /***
- * Converts given votes map to a list of StatePoints,
- * fill the statePoints list with the votes counts from the votes map
- *  Sorts the list from most voted state to least voted state
- * @param votes votes map to create the statePoints list from
- * @return pointer to the new sorted statePoints list
+ * Deallocate a point vector index. If index is NULL nothing is done.
+ * @param index the index to deallocate
  */
-List convertVotesToList(Map votes);
+void pointIndexDestroy(PointIndex index);
 
 /***
- * Converts given sorted list of statePoints to a sorted array
- * of 10 IDs (integers) of the first 10 states in the statePoints list
- * @param votes_list statePoints list
- * @return pointer to the new IDs array
+ * Fills an array of 10 IDs (integers) with the ranking of a state's votes
+ * (the IDs of the states it gave the most votes to, in order).
+ * If the state voted for less than 10 states, the rest are NO_STATE.
+ * @param votes votes row of the state
+ * @param state_results array of NUMBER_OF_RANKINGS IDs to fill
  */
-int *getStateResults(List votes_list);
+void getStateResults(Votes votes, int *state_results);
 
 /***
- * Converts final ranking of states (in StatePoints List)
+ * Converts final ranking of states (in a point vector)
  * to list of states names (strings List)
- * @param final_results the final sorted statePoints list
- * @param states states map that contains the states in the statePoints list
+ * @param final_results the final point vector, sorted at least up to count
+ * @param count number of states to convert from the start of the vector
+ *   (all of them if it's bigger than the vector's size)
+ * @param states states map that contains the states in the point vector
  * @return pointer to the new strings list of states names
  */
-List convertToStringList(List final_results, Map states);
+List convertToStringList(PointVector final_results, int count, Map states);
 
 /********************** CONTEST FUNCTIONS ***********************/
 /***
@@ -182,74 +201,140 @@ Ranking getRanking(int place);
  *  Receives an array of up to 10 state IDs
  *  and gives each state points according to their order
  *  using the Ranking enum
- * @param points_list pointer to a statePoints list to fill with the given points
+ * @param points_index index of the point vector to fill with the given points
  * @param results sorted array of up to 10 state IDs that need to get the points
  */
-void distributePoints(List points_list, const int *results);
+void distributePoints(PointIndex points_index, const int *results);
 
 /***
- * Returns a statePoints list of each state's points given by the audience
+ * Creates a pool of threads for the audience tallies. The threads are started once
+ * and wait for tallies until the pool is destroyed, so a tally doesn't start threads.
+ * The calling thread of a tally works on it too, so the tally is done even if some
+ * of the threads couldn't be started.
+ * @param thread_count number of threads that tally, with the calling thread (more than 1)
+ * @return pointer to the new pool, NULL if an allocation failed
+ */
+TallyPool tallyPoolCreate(int thread_count);
+
+/***
+ * Stops the threads of a pool and deallocates it
+ * @param pool the pool to destroy (may be NULL)
+ */
+void tallyPoolDestroy(TallyPool pool);
+
+/***
+ * Gets the number of threads that tally with a pool
+ * @param pool the pool (NULL for tallying on the calling thread only)
+ * @return the thread count given to tallyPoolCreate, 1 for NULL
+ */
+int tallyPoolGetThreadCount(TallyPool pool);
+
+/***
+ * Returns a point vector of each state's points given by the audience.
+ * The givers can be split between the threads of a pool, each one tallies its givers
+ * separately and the tallies are added up at the end (the result is the same).
  * @param states states map that contains the needed states
- * @return pointer to the new statePoints list
+ * @param pool the threads to tally with (NULL for tallying on the calling thread only),
+ *   used by one tally at a time
+ * @return pointer to the new point vector
  */
-List getAudiencePoints(Map states);
+PointVector getAudiencePoints(Map states, TallyPool pool);
 
 /***
- * Returns a statePoints list of each state's points given by the judges
+ * Returns a point vector of each state's points given by the judges
+ * (in the same order as the vector returned by getAudiencePoints)
  * @param judges judges map that contains the needed states
  * @param states states map that contains the needed states
- * @return pointer to the new statePoints list
+ * @return pointer to the new point vector
  */
-List getJudgesPoints(Map judges, Map states);
+PointVector getJudgesPoints(JudgeMap judges, Map states);
 
 /***
  *  Divides each state's audience points by the number of states minus one
  *  and multiplies it by the audience percentage.
  *  Does the same things for each state's judge points (not minus one).
  *  Finally, it adds to each state's audience points its corresponding judge points.
- * @param audience_points pointer to a statePoints list containing the audience points to the states
- * @param judge_points pointer to a statePoints list containing the judges points to the states
+ *  All the final points are multiplied by (number of states minus one) * (number of judges)
+ *  so they're calculated exactly in integers (the ranking is the same).
+ *  The audience and judge points aren't changed, so several final calculations
+ *  can be made from the same points.
+ * @param audience_points point vector containing the audience points to the states
+ * @param judge_points point vector containing the judges points to the states (in the same order)
+ * @param final_points point vector of the same size to fill with the final points
+ *   (in the same order, may be audience_points itself)
  * @param num_of_states number of states in the eurovision
  * @param num_of_judges number of judges to the eurovision
  * @param audience_percent wanted percentage of the audience points in the final calculation
  */
-void calculateFinalPoints(List audience_points, List judge_points,
+void calculateFinalPoints(PointVector audience_points, PointVector judge_points,
+                          PointVector final_points,
                           int num_of_states, int num_of_judges,
                           int audience_percent);
 
-/********************** FRIENDLY STATE FUNCTIONS ***********************/
-/**
- * String compare function for string list lexicographical sort
- * @param str1
- * @param str2
- * @return
- *   Positive integer if first string is after the second in the dictionary
- *   Negative integer if first string is before the second in the dictionary
- *   0 if strings are equal
+/********************** SCOREBOARD FUNCTIONS ***********************
+* The scoreboard is the audience and judge points of each state, kept in its StateData
+* and updated on every change, so the standings can be read without a new tally. */
+
+/***
+ * Adds the points of a ranking to (or subtracts them from) the states on the scoreboard
+ * @param states states map that contains the ranked states
+ * @param results sorted array of up to 10 state IDs (NO_STATE for an empty place)
+ * @param sign 1 for adding the points, -1 for subtracting them
+ * @param from_judge true if the ranking is a judge's results, false if it's a state's votes
  */
-int stringCompare(void* str1, void* str2);
+void scoreboardApplyRanking(Map states, const int *results, int sign, bool from_judge);
 
-/**
- * Get a map that shows each state's "favorite state"
- * (key = state's id, value = favorite state's id)
- * @param states - A map of states
- * @return Returns a map that matches each state's ID
- *   to the ID of the state that they gave most votes to
+/***
+ * Updates the audience points on the scoreboard after a state's ranking changed.
+ * Only the places that changed are updated.
+ * @param states states map that contains the ranked states
+ * @param old_results the state's ranking before the change
+ * @param new_results the state's ranking after the change
  */
-Map getStateFavorites(Map states);
+void scoreboardUpdateRanking(Map states, const int *old_results, const int *new_results);
 
 /***
- * Check if states are friendly by the assigment definition
- * @param stateId1 - first state's id
- * @param favState1 - first state's "favorite state"'s id
- * @param stateId2 - second state's id
- * @param favState2 - second state's "favorite state"'s id
- * @return
- *   false if one of the given pointers is NULL or states are not friendly
- *   true if states are friendly
+ * Returns a point vector of each state's points on the scoreboard
+ * (in the same order as the vectors returned by getAudiencePoints and getJudgesPoints)
+ * @param states states map that contains the needed states
+ * @param from_judges true for the judge points, false for the audience points
+ * @return pointer to the new point vector
+ */
+PointVector getScoreboardPoints(Map states, bool from_judges);
+
+/********************** JUDGE INDEX FUNCTIONS ***********************
+* Each state keeps the IDs of the judges that ranked it (see stateGetJudges),
+* so the judges affected by removing a state are found without going over all the judges. */
+
+/***
+ * Adds a judge to the judges of each state in its results
+ * @param states states map that contains the ranked states
+ * @param judge_id ID of the judge
+ * @param results the judge's results
+ * @return false if an allocation failed (nothing is added), true otherwise
+ */
+bool judgeIndexAdd(Map states, int judge_id, const int *results);
+
+/***
+ * Removes a judge from the judges of each state in its results
+ * @param states states map that contains the ranked states
+ * @param judge_id ID of the judge
+ * @param results the judge's results
+ * @return false if an allocation failed (nothing is removed), true otherwise
  */
-bool statesAreFriendly(const int *stateId1, const int *favState1,
-                       const int *stateId2, const int *favState2);
+bool judgeIndexRemove(Map states, int judge_id, const int *results);
+
+/***
+ * Makes each state in a ranking writable (see stateMakeWritable)
+ * @param states states map that contains the ranked states
+ * @param results the ranking (NUMBER_OF_RANKINGS state IDs, empty places are skipped)
+ * @return false if an allocation failed, true otherwise
+ */
+bool statesMakeWritable(Map states, const int *results);
+
+/********************** FRIENDLY STATE FUNCTIONS ***********************
+* The friendly pairs are kept in a set that's updated whenever a state's favorite state changes,
+* ordered the same way as their strings, so listing them needs no sort. */
 
 /**
  * Returns a string of two states that are "friendly".
@@ -262,15 +347,49 @@ bool statesAreFriendly(const int *stateId1, const int *favState1,
  */
 char *getStatePair(StateData state1, StateData state2);
 
-/**
- * Get a string list of states that are "friendly".
- * Each string is ordered lexicographically (not the list)
+/***
+ * Creates an empty set of friendly pairs
+ * @return NULL if an allocation failed, the new set otherwise
+ */
+FriendlyPairs friendlyPairsCreate();
+
+/***
+ * Creates a copy of a set of friendly pairs
+ * @param pairs the set to copy
+ * @return NULL if NULL was sent or an allocation failed, the new set otherwise
+ */
+FriendlyPairs friendlyPairsCopy(FriendlyPairs pairs);
+
+/***
+ * Deallocates a set of friendly pairs. If pairs is NULL nothing is done.
+ * @param pairs the set to deallocate
+ */
+void friendlyPairsDestroy(FriendlyPairs pairs);
+
+/***
+ * Updates the friendly pairs after a state's favorite state may have changed
+ * (call it after every change of the state's votes).
+ * If an allocation fails the set is rebuilt by the next friendlyPairsGetList.
+ * @param pairs the set of friendly pairs
+ * @param states states map that contains the state
+ * @param state_id ID of the state whose votes changed
+ * @param state_data the state's data
+ * @param old_favorite the state's favorite state before the change
+ */
+void friendlyPairsUpdate(FriendlyPairs pairs, Map states, int state_id, StateData state_data,
+                         int old_favorite);
+
+/***
+ * Get a string list of states that are "friendly", sorted lexicographically.
+ * Each string is ordered lexicographically as well.
+ * @param pairs the set of friendly pairs
  * @param states - Map of states
  * @return
+ *   NULL if an allocation failed
  *   Returns a list of "friendly" states as defined in the assignment:
  *   A list of strings of state name pairs in which each state's most votes went to the other state
  *   in the pair.
  */
-List getFriendlyStates(Map states);
+List friendlyPairsGetList(FriendlyPairs pairs, Map states);
 
 #endif //FUNCTIONS_H
@@ -0,0 +1,197 @@
+#ifndef INTMAP_H_
+#define INTMAP_H_
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "map.h"    // for MapResult
+
+/**
+* Typed Int-Keyed Map Generator
+*
+* Generates a map type for int keys and data of a given type at compile time.
+* The pairs are kept inline in one array sorted by key, so there's no
+* allocation per pair, no boxed keys or data, and the key comparisons are
+* plain int comparisons the compiler can inline (no compareMapKeyElements
+* call through a function pointer).
+* Pointers into the map (returned by Get and GetEntries) are valid until the
+* map is changed.
+*
+* INT_MAP_DEFINE(Name, prefix, DataType, freeData) defines the types
+*   Name##Entry     - A (key, data) pair of the map
+*   Name            - The map type (a pointer to the map struct)
+* and the functions:
+*   prefix##Create	    - Creates a new empty map
+*   prefix##Destroy	- Deletes a map, freeing all of its data with freeData
+*   prefix##GetSize	- Returns the number of pairs in the map
+*   prefix##GetEntries - Returns the pairs of the map, sorted by key
+*   prefix##Get		- Returns a pointer to the data paired to a key
+*   prefix##Contains	- Returns whether or not a key exists inside the map
+*   prefix##Put		- Gives a key a given value. The data is stored as is,
+*                        and the map frees it with freeData when its pair is
+*                        removed or its value is overridden.
+*   prefix##Remove		- Removes a pair, freeing its data with freeData
+* freeData is called with a data element, use INT_MAP_FREE_NOTHING for data
+* that doesn't own any memory.
+*
+* INT_MAP_DEFINE_COPY(Name, prefix, copyData) also defines
+*   prefix##Copy		- Copies a map, copying each data element with copyData,
+*                        which can't fail (use INT_MAP_COPY_VALUE for data that
+*                        is copied by value, or a function that shares the data)
+*
+* INT_MAP_FOREACH - A macro for iterating over the pairs of a map.
+*/
+
+/** initial number of pairs allocated for a typed map */
+#define INT_MAP_INITIAL_CAPACITY 4
+
+/** copy function for data that is copied by value */
+#define INT_MAP_COPY_VALUE(data) (data)
+
+/** free function for data that doesn't own any memory */
+#define INT_MAP_FREE_NOTHING(data) ((void)(data))
+
+#define INT_MAP_DEFINE(Name, prefix, DataType, freeData)                                    \
+                                                                                            \
+typedef struct Name##Entry_t {                                                              \
+    int key;                                                                                \
+    DataType data;                                                                          \
+} Name##Entry;                                                                              \
+                                                                                            \
+typedef struct Name##_t {                                                                   \
+    Name##Entry *entries;   /* sorted by key */                                             \
+    int size;               /* number of pairs in use */                                    \
+    int capacity;           /* number of pairs allocated */                                 \
+} *Name;                                                                                    \
+                                                                                            \
+static inline Name prefix##Create() {                                                       \
+    Name map = malloc(sizeof(*map));                                                        \
+    if (!map) return NULL;                                                                  \
+    map->entries = malloc(sizeof(*map->entries) * INT_MAP_INITIAL_CAPACITY);                \
+    if (!map->entries) {                                                                    \
+        free(map);                                                                          \
+        return NULL;                                                                        \
+    }                                                                                       \
+    map->size = 0;                                                                          \
+    map->capacity = INT_MAP_INITIAL_CAPACITY;                                               \
+    return map;                                                                             \
+}                                                                                           \
+                                                                                            \
+static inline void prefix##Destroy(Name map) {                                              \
+    if (map) {                                                                              \
+        for (int i = 0; i < map->size; i++) {                                               \
+            freeData(map->entries[i].data);                                                 \
+        }                                                                                   \
+        free(map->entries);                                                                 \
+        free(map);                                                                          \
+    }                                                                                       \
+}                                                                                           \
+                                                                                            \
+static inline int prefix##GetSize(Name map) {                                               \
+    return map ? map->size : -1;                                                            \
+}                                                                                           \
+                                                                                            \
+static inline Name##Entry *prefix##GetEntries(Name map) {                                   \
+    return map ? map->entries : NULL;                                                       \
+}                                                                                           \
+                                                                                            \
+/* binary search, sets index to the key's pair or to the place it should be inserted at */  \
+static inline bool prefix##Find(Name map, int key, int *index) {                            \
+    int low = 0, high = map->size;                                                          \
+    while (low < high) {                                                                    \
+        int middle = low + (high - low) / 2;                                                \
+        if (map->entries[middle].key < key) {                                               \
+            low = middle + 1;                                                               \
+        } else {                                                                            \
+            high = middle;                                                                  \
+        }                                                                                   \
+    }                                                                                       \
+    *index = low;                                                                           \
+    return low < map->size && map->entries[low].key == key;                                 \
+}                                                                                           \
+                                                                                            \
+static inline DataType *prefix##Get(Name map, int key) {                                    \
+    int index;                                                                              \
+    if (!map || !prefix##Find(map, key, &index)) return NULL;                               \
+    return &map->entries[index].data;                                                       \
+}                                                                                           \
+                                                                                            \
+static inline bool prefix##Contains(Name map, int key) {                                    \
+    int index;                                                                              \
+    return map && prefix##Find(map, key, &index);                                           \
+}                                                                                           \
+                                                                                            \
+static inline MapResult prefix##Put(Name map, int key, DataType data) {                     \
+    if (!map) return MAP_NULL_ARGUMENT;                                                     \
+    int index;                                                                              \
+    if (prefix##Find(map, key, &index)) {                                                   \
+        freeData(map->entries[index].data);     /* override the old value */                \
+        map->entries[index].data = data;                                                    \
+        return MAP_SUCCESS;                                                                 \
+    }                                                                                       \
+    if (map->size == map->capacity) {                                                       \
+        int new_capacity = map->capacity * 2;   /* double the capacity */                   \
+        Name##Entry *new_entries = realloc(map->entries, sizeof(*new_entries) * new_capacity); \
+        if (!new_entries) return MAP_OUT_OF_MEMORY;                                         \
+        map->entries = new_entries;                                                         \
+        map->capacity = new_capacity;                                                       \
+    }                                                                                       \
+    /* move the bigger keys one place forward and insert the pair in its place */          \
+    memmove(map->entries + index + 1, map->entries + index,                                 \
+            sizeof(*map->entries) * (map->size - index));                                   \
+    map->entries[index].key = key;                                                          \
+    map->entries[index].data = data;                                                        \
+    map->size++;                                                                            \
+    return MAP_SUCCESS;                                                                     \
+}                                                                                           \
+                                                                                            \
+static inline MapResult prefix##Remove(Name map, int key) {                                 \
+    if (!map) return MAP_NULL_ARGUMENT;                                                     \
+    int index;                                                                              \
+    if (!prefix##Find(map, key, &index)) return MAP_ITEM_DOES_NOT_EXIST;                    \
+    freeData(map->entries[index].data);                                                     \
+    /* move the bigger keys one place back */                                              \
+    memmove(map->entries + index, map->entries + index + 1,                                 \
+            sizeof(*map->entries) * (map->size - index - 1));                               \
+    map->size--;                                                                            \
+    return MAP_SUCCESS;                                                                     \
+}
+
+#define INT_MAP_DEFINE_COPY(Name, prefix, copyData)                                         \
+                                                                                            \
+static inline Name prefix##Copy(Name map) {                                                 \
+    if (!map) return NULL;                                                                  \
+    Name copy = malloc(sizeof(*copy));                                                      \
+    if (!copy) return NULL;                                                                 \
+    /* allocate only what's needed (but never less than the initial capacity) */           \
+    int capacity = (map->size > INT_MAP_INITIAL_CAPACITY) ? map->size : INT_MAP_INITIAL_CAPACITY; \
+    copy->entries = malloc(sizeof(*copy->entries) * capacity);                              \
+    if (!copy->entries) {                                                                   \
+        free(copy);                                                                         \
+        return NULL;                                                                        \
+    }                                                                                       \
+    /* copy all the pairs at once, then copy the data of each one */                        \
+    memcpy(copy->entries, map->entries, sizeof(*map->entries) * map->size);                 \
+    for (int i = 0; i < map->size; i++) {                                                   \
+        copy->entries[i].data = copyData(map->entries[i].data);                             \
+    }                                                                                       \
+    copy->size = map->size;                                                                 \
+    copy->capacity = capacity;                                                              \
+    return copy;                                                                            \
+}
+
+/*!
+* Macro for iterating over the pairs of a typed map, by key order.
+* Declares a new pointer to the current pair (of type entryType *).
+* The map must not be changed during the loop.
+*/
+#define INT_MAP_FOREACH(entryType, entry, map) \
+    for(entryType *entry = (map)->entries ; \
+        entry < (map)->entries + (map)->size ;\
+        entry++)
+
+/** map from int keys to int values */
+INT_MAP_DEFINE(IntIntMap, intIntMap, int, INT_MAP_FREE_NOTHING)
+INT_MAP_DEFINE_COPY(IntIntMap, intIntMap, INT_MAP_COPY_VALUE)
+
+#endif /* INTMAP_H_ */
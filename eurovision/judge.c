@@ -13,51 +13,27 @@
  */
 
 struct JudgeData_t {
+    int references;     // number of owners of the struct (see judgeDataShare), not atomic
     char *name;
     int results[NUMBER_OF_RANKINGS];   // list of state IDs in the order of points to give
 };
 
 /********************** JUDGE MAP FUNCTIONS ***********************/
-JudgeKeyElement copyJudgeKeyElement(JudgeKeyElement key) {
-    return copyInt(key);    // get a copy of judge's ID
-}
-
 JudgeDataElement copyJudgeDataElement(JudgeDataElement data) {
-    JudgeData judge_data = (JudgeData)data;
-
-    // create JudgeData copy
-    JudgeData copy = malloc(sizeof(*copy));
-    if (!copy) return NULL;
-
-    // allocate memory for judge's name
-    copy->name = malloc(strlen(judge_data->name) + 1);
-    if (!copy->name) {
-        free(copy);
-        return NULL;
-    }
-
-    strcpy(copy->name, judge_data->name);   // copy the name
-
-    // copy the judge's points/results
-    for (int i = 0; i < NUMBER_OF_RANKINGS; i++) {
-        copy->results[i] = judge_data->results[i];
-    }
-
-    return copy;
-}
-
-void freeJudgeKeyElement(JudgeKeyElement key) {
-    freeInt(key);   // free memory allocation for judge's ID
+    return judgeDataShare(data);    // the judge's data is never changed, so it can be shared
 }
 
 void freeJudgeDataElement(JudgeDataElement data) {
     JudgeData judge_data = (JudgeData)data;
+    if (--judge_data->references > 0) return;  // another owner still uses it
+
     free(judge_data->name); // deallocate the judge's name
     free(judge_data);       // deallocate the JudgeData struct
 }
 
-int compareJudgeKeyElements(JudgeKeyElement key1, JudgeKeyElement key2) {
-    return compareInts(key1, key2); // compare two judges' IDs
+JudgeData judgeDataShare(JudgeData data) {
+    data->references++;
+    return data;
 }
 
 /********************** JUDGE DATA FUNCTIONS ***********************/
@@ -77,6 +53,7 @@ JudgeData judgeDataCreate(const char *judge_name, const int *judge_results) {
     strcpy(name, judge_name);
 
     // set the JudgeData's fields accordingly
+    data->references = 1;
     data->name = name;
 
     for (int i=0; i < NUMBER_OF_RANKINGS; i++) {
@@ -2,6 +2,7 @@
 #define JUDGES_H
 
 #include <stdbool.h>
+#include "intmap.h"
 
 /**
  *  File containing all macros, enums, structs and functions
@@ -16,45 +17,36 @@
 typedef struct JudgeData_t *JudgeData;
 
 typedef void* JudgeDataElement;
-typedef void* JudgeKeyElement;
 
 /********************** JUDGE MAP FUNCTIONS ***********************/
-/***
- * Function for copying a key element in Judges map.
- * @param key - The judge's ID
- * @return A copy of the judge's ID
- */
-JudgeKeyElement copyJudgeKeyElement(JudgeKeyElement key);
-
 /***
  * Copy function for the data element in Judges map.
+ * A judge's data never changes, so the copy is the same struct, shared (see judgeDataShare).
  * @param data - JudgeData struct with judge's name and results
  * @return A copy of the JudgeData struct
  */
 JudgeDataElement copyJudgeDataElement(JudgeDataElement data);
 
-/***
- * Function for deallocating a key element in Judges map.
- * @param key - The judge's ID
- */
-void freeJudgeKeyElement(JudgeKeyElement key);
-
 /***
  * Function for deallocating a data element in Judges map.
+ * The struct is deallocated when its last copy is.
  * @param data - JudgeData struct with judge's name and results
  */
 void freeJudgeDataElement(JudgeDataElement data);
 
 /***
- * Compare function for two keys in Judges map.
- * @param key1 - A judge's ID
- * @param key2 - A judge's ID
- * @return
- *   Positive integer if first key is bigger than the second
- *   Negative integer if first key is smaller than the second
- *   0 if keys are equal
+ * Shares a judge's data: the same struct is used by another owner,
+ * and is deallocated after both free it. The owners must not share or free
+ * the struct from different threads at the same time.
+ * @param data - JudgeData struct with judge's name and results
+ * @return data
  */
-int compareJudgeKeyElements(JudgeKeyElement key1, JudgeKeyElement key2);
+JudgeData judgeDataShare(JudgeData data);
+
+/** map from judge IDs to the judges' data, which it owns (see intmap.h).
+ *  Copies of the map share the judges' data. */
+INT_MAP_DEFINE(JudgeMap, judgeMap, JudgeData, freeJudgeDataElement)
+INT_MAP_DEFINE_COPY(JudgeMap, judgeMap, judgeDataShare)
 
 /********************** JUDGE DATA FUNCTIONS ***********************/
  /***
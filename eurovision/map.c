@@ -1,29 +1,55 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "map.h"
 
-/********************** ENUMS & STRUCTS ***********************/
-/** enums for mapIterateAndCompare return result */
-typedef enum CompareResult_t {
-    EQUAL,
-    EQUAL_TO_FIRST,
-    START_OF_MAP,
-    END_OF_MAP,
-    MIDDLE_OF_MAP
-} CompareResult;
+/********************** MACROS, ENUMS & STRUCTS ***********************/
+/** maximal number of levels in a skip list (enough for 4^16 pairs) */
+#define MAP_MAX_LEVEL 16
+
+/** a node is promoted to the next skip list level with probability 1/MAP_LEVEL_RATIO */
+#define MAP_LEVEL_RATIO 4
+
+/** seed of the random generator used for choosing skip list node heights */
+#define MAP_RANDOM_SEED 2463534242u
+
+/** number of height 1 nodes allocated together in a pooled map (each level gets a quarter of the one below) */
+#define MAP_POOL_SLAB_BLOCKS 64
+
+/** minimal number of nodes allocated together in a pooled map */
+#define MAP_POOL_MIN_SLAB_BLOCKS 2
+
+/* Define MAP_DEBUG_CHECKS (e.g. -DMAP_DEBUG_CHECKS) to check the size counter against
+ * the nodes of the map on every mapGetSize. The check walks the whole map, so it's off by default. */
 
 /** node struct for the map */
 typedef struct MapNode_t {
     MapKeyElement key;
     MapDataElement data;
-    struct MapNode_t *next;
+    struct MapNode_t *next;     // next node by key order (level 0 of the skip list)
+    int height;                 // number of levels this node is linked in
+    struct MapNode_t *skip[];   // links for levels 1 to height-1 (only in skip lists),
+                                // followed by the inline key and data (only in pooled maps)
 } *MapNode;
 
 /** map struct */
 struct Map_t {
-    MapNode head;
+    MapNode head;                           // first node (level 0 of the skip list)
+    MapNode skip_head[MAP_MAX_LEVEL - 1];   // first node in levels 1 to MAP_MAX_LEVEL-1
+    int height;                             // number of levels currently in use
+    int max_height;                         // 1 for a sorted list, MAP_MAX_LEVEL for a skip list
+    unsigned int seed;                      // random generator state for node heights
+    MapBackend backend;
+    int size;                               // number of pairs in the map
     MapNode iterator;
+    MapNode tail[MAP_MAX_LEVEL];            // last node in each level (see mapPutLast)
+    bool tail_valid;                        // false if the map changed since tail was saved
+    bool pooled;                            // nodes are allocated from node_pools instead of malloc
+    Pool node_pools[MAP_MAX_LEVEL];         // pool of the nodes of each height, created on first use
+    size_t key_size;                        // size of an inline key, 0 if keys are copied
+    size_t data_size;                       // size of inline data, 0 if data is copied
+    PoolStats stats;                        // node allocations of a map that isn't pooled
     copyMapDataElements copyDataElement;
     copyMapKeyElements copyKeyElement;
     freeMapDataElements freeDataElement;
@@ -32,39 +58,72 @@ struct Map_t {
 };
 
 /*************** HELP FUNCTIONS DECLARATIONS ****************/
+/** Allocates a map and initializes it as empty (used by the map creation functions and mapCopy) */
+static Map mapAllocate (copyMapDataElements copyDataElement,
+                        copyMapKeyElements copyKeyElement,
+                        freeMapDataElements freeDataElement,
+                        freeMapKeyElements freeKeyElement,
+                        compareMapKeyElements compareKeyElements,
+                        MapBackend backend, bool pooled, size_t key_size, size_t data_size);
+
+/** Allocates a node of the given height, without its key and data
+ * @return NULL if the allocation failed, the new node otherwise
+ */
+static MapNode nodeAllocate (Map map, int height);
+
 /** create a new node to add to the map (used in mapPut)
- * The new node's data is the given MapDataElement and it's key is a copy of the given MapKeyElement.
- * The one who uses this function is in charge of freeing new_data when there's an error.
+ * The new node's key and data are copies of the given MapKeyElement and MapDataElement
+ * (copied into the node itself if they're inline).
+ * @return NULL if an allocation failed, the new node otherwise
  * */
-static MapNode nodeCreate (Map map, MapKeyElement key, MapDataElement new_data);
-
-/** Deallocates a node */
-static void nodeDestroy (MapNode node);
-
-/** Iterate on the map & compare each keyElement to given keyElement
- *  Given node pointer is used as the iterator and is, therefore, changed
- *  If the given element is in the map:
- *      - given iterator will point to the node before the one the given element is in (unless it's the first node)
- *      - the function will return EQUAL or EQUAL_TO_FIRST appropriately
- *  If the given element is not on the map:
- *      - given iterator will point to the the place before the one the given element should be in
- *      - the function will return START_OF_MAP, MIDDLE_OF_MAP or END_OF_MAP depending or where the node should go
- *        (MIDDLE_OF_MAP refers to any place that's not the beginning or the end)
- *
- * */
-static CompareResult mapIterateAndCompare (Map map, MapKeyElement key, MapNode *iterator);
+static MapNode nodeCreate (Map map, MapKeyElement key, MapDataElement data, int height);
 
-/** Used in mapPut for updating an existing node
- *  Updates the node which the map iterator is on with the new data that is received.
- *  Makes sure to deallocate the data that was in the node beforehand.
+/** Replaces the data of a node with a copy of the given MapDataElement
+ * @return MAP_OUT_OF_MEMORY if an allocation failed (the node is unchanged), MAP_SUCCESS otherwise
  */
-static void mapUpdateExistingNode(Map map, MapDataElement new_data);
+static MapResult nodeSetData (Map map, MapNode node, MapDataElement data);
+
+/** Frees the key and data of a node, unless they're inline */
+static void nodeFreeElements (Map map, MapNode node);
+
+/** Deallocates a node (without its key and data) */
+static void nodeDestroy (Map map, MapNode node);
 
-/** Used in mapPut for inserting a new node
- *  Inserts a new node based on the map iterator's position and the given compare result
- *  (START_OF_MAP / MIDDLE_OF_MAP / END_OF_MAP)
+/** Returns the size of a node of the given height without the inline key and data */
+static size_t nodeHeaderSize (int height);
+
+/** Returns the address of the link of given node in given level.
+ *  A NULL node stands for the head of the map.
  */
-static void mapInsertNewNode(Map map, MapNode new_node, CompareResult position);
+static MapNode *nodeLink (Map map, MapNode node, int level);
+
+#ifdef MAP_DEBUG_CHECKS
+/** Counts the nodes of the map by walking through it (used for checking the size counter) */
+static int mapCountNodes (Map map);
+#endif
+
+/** Choose the height of a new node (always 1 for a sorted list) */
+static int mapRandomHeight (Map map);
+
+/** Search the map for the node with the given key.
+ *  If update isn't NULL, update[level] is set to the last node before the key in each level
+ *  (NULL if the key belongs right after the head in that level).
+ *  Levels that aren't in use yet are set to NULL as well.
+ * @return the node with the given key, or NULL if the map doesn't contain it
+ */
+static MapNode mapFind (Map map, MapKeyElement key, MapNode *update);
+
+/** Saves the last node of each level in map->tail */
+static void mapFindTail (Map map);
+
+/** Links a new node in the map after the nodes found by mapFind */
+static void mapLinkNode (Map map, MapNode new_node, MapNode *update);
+
+/** Unlinks a node from the map, using the nodes found by mapFind */
+static void mapUnlinkNode (Map map, MapNode node, MapNode *update);
+
+/** Unlinks a node from the map (using the nodes found by mapFind) and deallocates it with its key and data */
+static void mapRemoveNode (Map map, MapNode node, MapNode *update);
 
 /********************** MAP FUNCTIONS ***********************/
 
@@ -73,32 +132,49 @@ Map mapCreate(copyMapDataElements copyDataElement,
               freeMapDataElements freeDataElement,
               freeMapKeyElements freeKeyElement,
               compareMapKeyElements compareKeyElements) {
+    return mapCreateWithBackend(copyDataElement, copyKeyElement,
+                                freeDataElement, freeKeyElement,
+                                compareKeyElements, MAP_BACKEND_SORTED_LIST);
+}
+
+Map mapCreateWithBackend(copyMapDataElements copyDataElement,
+                         copyMapKeyElements copyKeyElement,
+                         freeMapDataElements freeDataElement,
+                         freeMapKeyElements freeKeyElement,
+                         compareMapKeyElements compareKeyElements,
+                         MapBackend backend) {
     // NULL check for parameters
     if (!copyDataElement || !copyKeyElement || !freeDataElement || !freeKeyElement || !compareKeyElements)
         return NULL;
 
-    Map map = malloc(sizeof(*map));    // allocate memory for new map
-    if (!map) return NULL;    // allocation failed
-
-    // initialize empty map
-    map->head = NULL;
-    map->iterator = NULL;
+    return mapAllocate(copyDataElement, copyKeyElement, freeDataElement, freeKeyElement,
+                       compareKeyElements, backend, false, 0, 0);
+}
 
-    // initialize function pointers as given in parameters
-    map->copyDataElement = copyDataElement;
-    map->copyKeyElement = copyKeyElement;
-    map->freeDataElement = freeDataElement;
-    map->freeKeyElement = freeKeyElement;
-    map->compareKeyElements = compareKeyElements;
+Map mapCreatePooled(copyMapDataElements copyDataElement,
+                    copyMapKeyElements copyKeyElement,
+                    freeMapDataElements freeDataElement,
+                    freeMapKeyElements freeKeyElement,
+                    compareMapKeyElements compareKeyElements,
+                    MapBackend backend, size_t keySize, size_t dataSize) {
+    // NULL check for parameters (the copy and free functions of inline elements aren't used)
+    if ((!copyDataElement && dataSize == 0) || (!copyKeyElement && keySize == 0) ||
+        (!freeDataElement && dataSize == 0) || (!freeKeyElement && keySize == 0) || !compareKeyElements)
+        return NULL;
 
-    return map; // return map pointer
+    return mapAllocate(copyDataElement, copyKeyElement, freeDataElement, freeKeyElement,
+                       compareKeyElements, backend, true, keySize, dataSize);
 }
 
 void mapDestroy(Map map) {
     MapResult result = mapClear(map);   // deallocate all the nodes in the map
 
-    if (result == MAP_SUCCESS)  // if nodes deallocation was successful
-        free(map);              // deallocate the map
+    if (result == MAP_SUCCESS) {        // if nodes deallocation was successful
+        for (int level = 0; level < MAP_MAX_LEVEL; level++) {
+            poolDestroy(map->node_pools[level]);
+        }
+        free(map);                      // deallocate the map
+    }
 
     // if a null pointer was sent do nothing
 }
@@ -106,18 +182,19 @@ void mapDestroy(Map map) {
 Map mapCopy(Map map) {
     if (!map) return NULL;  // NULL pointer was sent
 
-    // create map copy
-    Map copy = mapCreate(map->copyDataElement,
-                         map->copyKeyElement,
-                         map->freeDataElement,
-                         map->freeKeyElement,
-                         map->compareKeyElements);
+    // create map copy (with the same backend and allocation scheme)
+    Map copy = mapAllocate(map->copyDataElement,
+                           map->copyKeyElement,
+                           map->freeDataElement,
+                           map->freeKeyElement,
+                           map->compareKeyElements,
+                           map->backend, map->pooled, map->key_size, map->data_size);
 
     if (!copy) return NULL; // allocation failed
 
-    //iterate on the map and copy all pairs
+    //iterate on the map and copy all pairs (in order, so each one is added after the last one)
     for (MapNode ptr = map->head; ptr ; ptr = ptr->next) {
-        MapResult result = mapPut(copy, ptr->key, ptr->data);   // add a copy of each node to the map copy
+        MapResult result = mapPutLast(copy, ptr->key, ptr->data);   // add a copy of each node to the map copy
 
         if (result == MAP_OUT_OF_MEMORY) {
             mapDestroy(copy);   // free all nodes created so far
@@ -131,102 +208,131 @@ Map mapCopy(Map map) {
 int mapGetSize(Map map) {
     if (!map) return -1;  // NULL pointer received
 
-    //iterate on the map and increment counter
-    int count = 0;
-    for (MapNode ptr = map->head; ptr ; ptr = ptr->next) {
-        count++;
-    }
+#ifdef MAP_DEBUG_CHECKS
+    assert(map->size == mapCountNodes(map));    // the counter must match the actual number of nodes
+#endif
 
-    return count;
+    return map->size;
 }
 
 bool mapContains(Map map, MapKeyElement element) {
     if (!map || !element) return false; // NULL pointer was sent
 
-    //iterate on the map and check if the given key element is contained
-    MapNode ptr = map->head;
-    CompareResult compare_result = mapIterateAndCompare(map, element, &ptr);
+    // search the map for the given key element
+    return mapFind(map, element, NULL) != NULL;
+}
+
+MapResult mapPut(Map map, MapKeyElement keyElement, MapDataElement dataElement) {
+    // NULL check for parameters
+    if (!map || !keyElement || !dataElement) return MAP_NULL_ARGUMENT;
 
-    if (compare_result == EQUAL || compare_result == EQUAL_TO_FIRST) return true;   // element found
+    // search the map and save the nodes before the key in each level
+    MapNode update[MAP_MAX_LEVEL];
+    MapNode node = mapFind(map, keyElement, update);
 
-    return false;   // element not found
+    if (node) {
+        return nodeSetData(map, node, dataElement);     // if the node exists replace its data
+    }
+
+    MapNode new_node = nodeCreate(map, keyElement, dataElement, mapRandomHeight(map)); // otherwise create a new one
+    if (!new_node) return MAP_OUT_OF_MEMORY;
+    mapLinkNode(map, new_node, update);     // and insert it where it should be
+    map->size++;
+
+    return MAP_SUCCESS;
 }
 
-MapResult mapPut(Map map, MapKeyElement keyElement, MapDataElement dataElement) {
+MapResult mapPutMove(Map map, MapKeyElement keyElement, MapDataElement dataElement) {
     // NULL check for parameters
     if (!map || !keyElement || !dataElement) return MAP_NULL_ARGUMENT;
 
-    // copy data
-    MapDataElement new_data = map->copyDataElement(dataElement);
-    if (!new_data) return MAP_OUT_OF_MEMORY;
+    // search the map and save the nodes before the key in each level
+    MapNode update[MAP_MAX_LEVEL];
+    MapNode node = mapFind(map, keyElement, update);
+
+    if (node) {
+        // the map keeps its own key, and the given data replaces the existing data
+        if (map->key_size == 0) map->freeKeyElement(keyElement);
+        if (map->data_size > 0) {
+            memcpy(node->data, dataElement, map->data_size);
+        } else {
+            map->freeDataElement(node->data);
+            node->data = dataElement;
+        }
+        return MAP_SUCCESS;
+    }
 
-    // iterate on the map and compare, map iterator is changed
-    mapGetFirst(map);
-    CompareResult compare_result = mapIterateAndCompare(map, keyElement, &(map->iterator));
+    MapNode new_node = nodeAllocate(map, mapRandomHeight(map));   // otherwise create a new node
+    if (!new_node) return MAP_OUT_OF_MEMORY;
 
-    // map iterator is used to help update an existing node or insert a new one
-    if (compare_result == EQUAL || compare_result == EQUAL_TO_FIRST) {
-        if (compare_result == EQUAL)            // if the node exists, but it's not the first in the map
-            mapGetNext(map);                    // the iterator is pointing to one before, so we increment it
-        mapUpdateExistingNode(map, new_data);   // update the data of the node the iterator is on
+    // take the given key and data (inline elements are copied into the node)
+    size_t header_size = nodeHeaderSize(new_node->height);
+    if (map->key_size > 0) {
+        new_node->key = (char *)new_node + header_size;
+        memcpy(new_node->key, keyElement, map->key_size);
     } else {
-        MapNode new_node = nodeCreate(map, keyElement, new_data);   // if the node doesn't exist, create a new one
-        if (!new_node) {
-            map->freeDataElement(new_data);
-            return MAP_OUT_OF_MEMORY;
-        }
-        mapInsertNewNode(map, new_node, compare_result);   // insert a new node after the one the iterator is on
+        new_node->key = keyElement;
+    }
+    if (map->data_size > 0) {
+        new_node->data = (char *)new_node + header_size + poolRoundSize(map->key_size);
+        memcpy(new_node->data, dataElement, map->data_size);
+    } else {
+        new_node->data = dataElement;
     }
 
+    mapLinkNode(map, new_node, update);     // and insert it where it should be
+    map->size++;
+
+    return MAP_SUCCESS;
+}
+
+MapResult mapPutLast(Map map, MapKeyElement keyElement, MapDataElement dataElement) {
+    // NULL check for parameters
+    if (!map || !keyElement || !dataElement) return MAP_NULL_ARGUMENT;
+
+    if (!map->tail_valid) mapFindTail(map);
+
+    // a key that isn't bigger than the last key is put in its place
+    MapNode last = map->tail[0];
+    if (last != NULL && map->compareKeyElements(last->key, keyElement) >= 0) {
+        return mapPut(map, keyElement, dataElement);
+    }
+
+    MapNode new_node = nodeCreate(map, keyElement, dataElement, mapRandomHeight(map));
+    if (!new_node) return MAP_OUT_OF_MEMORY;
+    mapLinkNode(map, new_node, map->tail);  // link it after the last node in each of its levels
+    map->size++;
+
+    // the new node is the last node in its levels
+    for (int level = 0; level < new_node->height; level++) {
+        map->tail[level] = new_node;
+    }
+    map->tail_valid = true;
+
     return MAP_SUCCESS;
 }
 
 MapDataElement mapGet(Map map, MapKeyElement keyElement){
     if (!map || !keyElement) return NULL;   // NULL parameter received
 
-    //iterate on the map and compare each node's key with the user's function
-    MapNode ptr = map->head;
-    CompareResult compare_result = mapIterateAndCompare(map, keyElement, &ptr);
-
-    if (compare_result == EQUAL) return ptr->next->data;    // if found return the data
-    if (compare_result == EQUAL_TO_FIRST) return ptr->data; // different actions if it is equal to the first
+    // search the map for the given key element
+    MapNode node = mapFind(map, keyElement, NULL);
 
-    return NULL;  // key element not found
+    return node ? node->data : NULL;    // if found return the data
 }
 
 MapResult mapRemove(Map map, MapKeyElement keyElement) {
     if (!map || !keyElement) return MAP_NULL_ARGUMENT;  // NULL parameter received
 
-    // iterate on the map and compare
-    mapGetFirst(map);
-    CompareResult compare_result = mapIterateAndCompare(map, keyElement, &(map->iterator));
+    // search the map and save the nodes before the key in each level
+    MapNode update[MAP_MAX_LEVEL];
+    MapNode node_to_remove = mapFind(map, keyElement, update);
 
-    if (compare_result != EQUAL && compare_result != EQUAL_TO_FIRST) {
+    if (!node_to_remove) {
         return MAP_ITEM_DOES_NOT_EXIST;         // map doesn't contain given key
     }
 
-    MapNode prev_node = map->iterator;          // save the previous node
-    if (compare_result == EQUAL) {
-        mapGetNext(map);                        // if EQUAL_TO_FIRST, prev_node = node_to_remove = map->head
-    }
-    MapNode node_to_remove = map->iterator;     // get the node you have to remove
-    MapNode next_node = node_to_remove->next;   // save the next node
-
-    // deallocate the node we want to remove (with it's data and key)
-    map->freeDataElement(node_to_remove->data);
-    map->freeKeyElement(node_to_remove->key);
-    nodeDestroy(node_to_remove);
-
-    if (compare_result == EQUAL_TO_FIRST) {
-        map->head = next_node;          // if it's equal to the first node, update the map's head
-    } else {
-        prev_node->next = next_node;    // otherwise, connect the previous and next node
-    }
-
-    // if empty map, reset iterator
-    if (map->head == NULL) {
-        map->iterator = NULL;
-    }
+    mapRemoveNode(map, node_to_remove, update);
 
     return MAP_SUCCESS;
 }
@@ -240,7 +346,7 @@ MapKeyElement mapGetFirst(Map map) {
 }
 
 MapKeyElement mapGetNext(Map map) {
-    if (!map || map->head == NULL) return NULL; // map is empty or NULL pointer received
+    if (!map || map->iterator == NULL) return NULL; // iterator is invalid or NULL pointer received
 
     map->iterator = map->iterator->next;        // increment iterator
 
@@ -249,97 +355,347 @@ MapKeyElement mapGetNext(Map map) {
     return map->iterator->key;                  // return the current key
 }
 
+MapKeyElement mapIteratorFirst(Map map, MapIterator *iterator) {
+    if (!iterator) return NULL;     // NULL pointer received
+
+    iterator->node = map ? map->head : NULL;    // set the iterator to the first node
+
+    return iterator->node ? iterator->node->key : NULL;
+}
+
+MapKeyElement mapIteratorNext(MapIterator *iterator) {
+    if (!iterator || iterator->node == NULL) return NULL;  // NULL pointer received or already at the end
+
+    iterator->node = iterator->node->next;      // increment the iterator
+
+    return iterator->node ? iterator->node->key : NULL;
+}
+
+MapDataElement mapIteratorGetData(MapIterator *iterator) {
+    if (!iterator || iterator->node == NULL) return NULL;  // NULL pointer received or at the end
+
+    return iterator->node->data;
+}
+
 MapResult mapClear(Map map) {
     if (!map) return MAP_NULL_ARGUMENT;   // NULL pointer was sent.
 
-    // iterate on the map and free all key-data pairs
-    MapNode ptr = map->head;
-    while (ptr != NULL) {
-        // free the key and data with the user's function
-        map->freeKeyElement(ptr->key);
-        map->freeDataElement(ptr->data);
+    if (map->pooled) {
+        // free the keys and data that aren't inline, then return all the nodes to their pools at once
+        if (map->key_size == 0 || map->data_size == 0) {
+            for (MapNode ptr = map->head; ptr ; ptr = ptr->next) {
+                nodeFreeElements(map, ptr);
+            }
+        }
+        for (int level = 0; level < MAP_MAX_LEVEL; level++) {
+            poolClear(map->node_pools[level]);
+        }
+    } else {
+        // iterate on the map and free all key-data pairs
+        MapNode ptr = map->head;
+        while (ptr != NULL) {
+            nodeFreeElements(map, ptr);     // free the key and data with the user's function
+
+            MapNode node_to_destroy = ptr;
+            ptr = ptr->next;                // increment the pointer
+            nodeDestroy(map, node_to_destroy);  // free the current node
+        }
+    }
 
-        MapNode node_to_destroy = ptr;
-        ptr = ptr->next;                // increment the pointer
-        nodeDestroy(node_to_destroy);     // free the current node
+    // set map as empty
+    map->head = NULL;
+    for (int level = 1; level < map->height; level++) {
+        map->skip_head[level - 1] = NULL;
     }
+    map->height = 1;
+    map->size = 0;
+    map->iterator = NULL;
+    map->tail_valid = false;
 
-    map->head = NULL;   // set map as empty
-    map->iterator = NULL; // set map as empty
+    return MAP_SUCCESS;
+}
+
+MapResult mapGetAllocatorStats(Map map, PoolStats *stats) {
+    if (!map || !stats) return MAP_NULL_ARGUMENT;   // NULL pointer was sent
+
+    // nodes of a map that isn't pooled are counted by the map, the rest by the pools
+    *stats = map->stats;
+    for (int level = 0; level < MAP_MAX_LEVEL; level++) {
+        PoolStats pool_stats = poolGetStats(map->node_pools[level]);
+        stats->allocations += pool_stats.allocations;
+        stats->releases += pool_stats.releases;
+        stats->system_allocations += pool_stats.system_allocations;
+        stats->system_releases += pool_stats.system_releases;
+    }
 
     return MAP_SUCCESS;
 }
 
 /****************** HELP FUNCTIONS IMPLEMENTATIONS *******************/
-static MapNode nodeCreate (Map map, MapKeyElement key, MapDataElement new_data) {
-    MapNode node = malloc(sizeof(*node));
+static Map mapAllocate (copyMapDataElements copyDataElement,
+                        copyMapKeyElements copyKeyElement,
+                        freeMapDataElements freeDataElement,
+                        freeMapKeyElements freeKeyElement,
+                        compareMapKeyElements compareKeyElements,
+                        MapBackend backend, bool pooled, size_t key_size, size_t data_size) {
+    Map map = malloc(sizeof(*map));    // allocate memory for new map
+    if (!map) return NULL;    // allocation failed
+
+    // initialize empty map
+    map->head = NULL;
+    for (int level = 1; level < MAP_MAX_LEVEL; level++) {
+        map->skip_head[level - 1] = NULL;
+    }
+    map->height = 1;
+    map->max_height = (backend == MAP_BACKEND_SKIP_LIST) ? MAP_MAX_LEVEL : 1;
+    map->seed = MAP_RANDOM_SEED;
+    map->backend = backend;
+    map->size = 0;
+    map->iterator = NULL;
+    map->tail_valid = false;
+
+    // initialize the allocation scheme
+    map->pooled = pooled;
+    for (int level = 0; level < MAP_MAX_LEVEL; level++) {
+        map->node_pools[level] = NULL;
+    }
+    map->key_size = key_size;
+    map->data_size = data_size;
+    map->stats = poolGetStats(NULL);
+
+    // initialize function pointers as given in parameters
+    map->copyDataElement = copyDataElement;
+    map->copyKeyElement = copyKeyElement;
+    map->freeDataElement = freeDataElement;
+    map->freeKeyElement = freeKeyElement;
+    map->compareKeyElements = compareKeyElements;
+
+    return map; // return map pointer
+}
+static MapNode nodeCreate (Map map, MapKeyElement key, MapDataElement data, int height) {
+    MapNode node = nodeAllocate(map, height);
     if (!node) return NULL;
 
-    MapKeyElement new_key = map->copyKeyElement(key);
-    if (!new_key) {
-        nodeDestroy(node);
-        return NULL;
+    size_t header_size = nodeHeaderSize(height);
+
+    // copy the key
+    if (map->key_size > 0) {
+        node->key = (char *)node + header_size;
+        memcpy(node->key, key, map->key_size);
+    } else {
+        node->key = map->copyKeyElement(key);
+        if (!node->key) {
+            nodeDestroy(map, node);
+            return NULL;
+        }
     }
 
-    node->data = new_data;
-    node->key = new_key;
+    // copy the data
+    if (map->data_size > 0) {
+        node->data = (char *)node + header_size + poolRoundSize(map->key_size);
+        memcpy(node->data, data, map->data_size);
+    } else {
+        node->data = map->copyDataElement(data);
+        if (!node->data) {
+            if (map->key_size == 0) map->freeKeyElement(node->key);
+            nodeDestroy(map, node);
+            return NULL;
+        }
+    }
+
+    return node;
+}
+
+static MapNode nodeAllocate (Map map, int height) {
+    size_t header_size = nodeHeaderSize(height);
+    MapNode node;
+    if (map->pooled) {
+        // the inline key and data are kept right after the links
+        Pool *pool = &(map->node_pools[height - 1]);
+        if (*pool == NULL) {
+            int blocks = MAP_POOL_SLAB_BLOCKS >> (2 * (height - 1));
+            *pool = poolCreate(header_size + poolRoundSize(map->key_size) + map->data_size,
+                               blocks > MAP_POOL_MIN_SLAB_BLOCKS ? blocks : MAP_POOL_MIN_SLAB_BLOCKS);
+            if (*pool == NULL) return NULL;
+        }
+        node = poolAlloc(*pool);
+    } else {
+        node = malloc(header_size);
+        if (node) {
+            map->stats.allocations++;
+            map->stats.system_allocations++;
+        }
+    }
+    if (!node) return NULL;
+
+    node->height = height;
     node->next = NULL;
 
     return node;
 }
 
-static void nodeDestroy (MapNode node) {
-    free(node);
+static MapResult nodeSetData (Map map, MapNode node, MapDataElement data) {
+    if (map->data_size > 0) {
+        memcpy(node->data, data, map->data_size);   // overwrite the inline data
+        return MAP_SUCCESS;
+    }
+
+    MapDataElement new_data = map->copyDataElement(data);
+    if (!new_data) return MAP_OUT_OF_MEMORY;
+
+    map->freeDataElement(node->data);   // free the existing data
+    node->data = new_data;              // and set the new data
+
+    return MAP_SUCCESS;
 }
 
-static CompareResult mapIterateAndCompare (Map map, MapKeyElement key, MapNode *iterator) {
-    MapNode ptr = *iterator;
+static void nodeFreeElements (Map map, MapNode node) {
+    if (map->key_size == 0) map->freeKeyElement(node->key);
+    if (map->data_size == 0) map->freeDataElement(node->data);
+}
 
-    // if empty map or smallest key return START_OF_MAP
-    if (ptr == NULL || map->compareKeyElements(key, ptr->key) < 0) {
-        return START_OF_MAP;
+static void nodeDestroy (Map map, MapNode node) {
+    if (map->pooled) {
+        poolFree(map->node_pools[node->height - 1], node);
+    } else {
+        free(node);
+        map->stats.releases++;
+        map->stats.system_releases++;
     }
+}
+
+static size_t nodeHeaderSize (int height) {
+    return poolRoundSize(sizeof(struct MapNode_t) + (height - 1) * sizeof(MapNode));
+}
 
-    // if equal to the first
-    if (map->compareKeyElements(key, ptr->key) == EQUAL) {
-        return EQUAL_TO_FIRST;
+static MapNode *nodeLink (Map map, MapNode node, int level) {
+    assert(level >= 0 && level < MAP_MAX_LEVEL);
+
+    if (node == NULL) {
+        return level == 0 ? &(map->head) : &(map->skip_head[level - 1]);
     }
 
-    // iterate and compare
-    while (ptr->next != NULL && map->compareKeyElements(key, ptr->next->key) > 0) {
-        (*iterator) = ptr->next;
-        ptr = *iterator;
+    assert(level < node->height);
+    return level == 0 ? &(node->next) : &(node->skip[level - 1]);
+}
+
+#ifdef MAP_DEBUG_CHECKS
+static int mapCountNodes (Map map) {
+    //iterate on the map and increment counter
+    int count = 0;
+    for (MapNode ptr = map->head; ptr ; ptr = ptr->next) {
+        count++;
     }
 
-    // reached end of map
-    if (ptr->next == NULL) return END_OF_MAP;
+    return count;
+}
+#endif
 
-    // equality
-    if (map->compareKeyElements(key, ptr->next->key) == EQUAL) return EQUAL;
+static int mapRandomHeight (Map map) {
+    int height = 1;
 
-    return MIDDLE_OF_MAP;
+    // xorshift32 step, kept per map so runs are reproducible
+    while (height < map->max_height) {
+        map->seed ^= map->seed << 13;
+        map->seed ^= map->seed >> 17;
+        map->seed ^= map->seed << 5;
+
+        if (map->seed % MAP_LEVEL_RATIO != 0) break;
+        height++;
+    }
+
+    return height;
 }
 
-static void mapUpdateExistingNode(Map map, MapDataElement new_data) {
-    MapNode ptr = map->iterator;        // get the node
-    map->freeDataElement(ptr->data);    // free existing data
-    ptr->data = new_data;               // set new data
+static MapNode mapFind (Map map, MapKeyElement key, MapNode *update) {
+    MapNode ptr = NULL;     // NULL stands for the head of the map
+
+    // go down the levels, in each level move forward while the next key is smaller than the given key
+    for (int level = map->height - 1; level >= 0; level--) {
+        MapNode next = *nodeLink(map, ptr, level);
+        while (next != NULL && map->compareKeyElements(next->key, key) < 0) {
+            ptr = next;
+            next = *nodeLink(map, ptr, level);
+        }
+        if (update) update[level] = ptr;
+    }
+
+    // levels that aren't in use yet start at the head
+    if (update) {
+        for (int level = map->height; level < map->max_height; level++) {
+            update[level] = NULL;
+        }
+    }
+
+    // the node after ptr in level 0 is the first node with a key that isn't smaller than the given key
+    MapNode candidate = *nodeLink(map, ptr, 0);
+    if (candidate != NULL && map->compareKeyElements(candidate->key, key) == 0) {
+        return candidate;
+    }
+
+    return NULL;
 }
 
-static void mapInsertNewNode(Map map, MapNode new_node, CompareResult position) {
-    MapNode ptr = map->iterator;
-    switch (position) {
-        case START_OF_MAP:              // if the given key is the smallest key or map is empty
-            new_node->next = map->head;
-            map->head = new_node;       // insert the new node to the head
-            break;
-        case END_OF_MAP:    // if the given key is the largest key, insert in the end of map
-            ptr->next = new_node;
-            // new_node->next = NULL was done in the initialization of new_node
-            break;
-        default:            // case MIDDLE_OF_MAP: insert the new node where it should be
-            new_node->next = ptr->next;
-            ptr->next = new_node;
-            break;
+static void mapFindTail (Map map) {
+    MapNode ptr = NULL;     // NULL stands for the head of the map
+
+    // go down the levels, in each level move forward to the last node
+    for (int level = map->height - 1; level >= 0; level--) {
+        MapNode next = *nodeLink(map, ptr, level);
+        while (next != NULL) {
+            ptr = next;
+            next = *nodeLink(map, ptr, level);
+        }
+        map->tail[level] = ptr;
+    }
+
+    // levels that aren't in use yet end at the head
+    for (int level = map->height; level < map->max_height; level++) {
+        map->tail[level] = NULL;
+    }
+
+    map->tail_valid = true;
+}
+
+static void mapLinkNode (Map map, MapNode new_node, MapNode *update) {
+    map->tail_valid = false;    // the new node may be the last node in some levels
+
+    for (int level = 0; level < new_node->height; level++) {
+        MapNode *link = nodeLink(map, update[level], level);
+        *nodeLink(map, new_node, level) = *link;
+        *link = new_node;
+    }
+
+    if (new_node->height > map->height) {
+        map->height = new_node->height;
+    }
+}
+
+static void mapUnlinkNode (Map map, MapNode node, MapNode *update) {
+    map->tail_valid = false;    // the node may have been the last node in some levels
+
+    for (int level = 0; level < node->height; level++) {
+        MapNode *link = nodeLink(map, update[level], level);
+        assert(*link == node);
+        *link = *nodeLink(map, node, level);
+    }
+
+    // drop the levels that became empty
+    while (map->height > 1 && *nodeLink(map, NULL, map->height - 1) == NULL) {
+        map->height--;
+    }
+}
+
+static void mapRemoveNode (Map map, MapNode node, MapNode *update) {
+    mapUnlinkNode(map, node, update);   // connect the previous and next nodes in each level
+    map->size--;
+
+    // the iterator can't stay on a removed node
+    if (map->iterator == node) {
+        map->iterator = NULL;
     }
+
+    // deallocate the node we want to remove (with it's data and key)
+    nodeFreeElements(map, node);
+    nodeDestroy(map, node);
 }
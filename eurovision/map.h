@@ -2,25 +2,38 @@
 #define MAP_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "pool.h"
 
 /**
 * Generic Map Container
 *
 * Implements a map container type.
+* The pairs are kept ordered by key, either in a sorted linked list or in a
+* skip list (see MapBackend), so iterating over a map always yields the keys
+* in ascending order.
 * The map has an internal iterator for external use. For all functions
 * where the state of the iterator after calling that function is not stated,
 * it is undefined. That is you cannot assume anything about it.
 *
 * The following functions are available:
 *   mapCreate		- Creates a new empty map
+*   mapCreateWithBackend - Creates a new empty map using a given backend
+*   mapCreatePooled - Creates a new empty map that allocates its nodes from
+*                    pools, optionally keeping keys and data inside the nodes
 *   mapDestroy		- Deletes an existing map and frees all resources
 *   mapCopy		- Copies an existing map
-*   mapGetSize		- Returns the size of a given map
+*   mapGetSize		- Returns the size of a given map (in constant time)
 *   mapContains	- returns weather or not a key exists inside the map.
 *   				  This resets the internal iterator.
 *   mapPut		    - Gives a specific key a given value.
 *   				  If the key exists, the value is overridden.
 *   				  This resets the internal iterator.
+*   mapPutMove      - Same as mapPut, but the map takes the given key and
+*                    data as they are instead of copying them.
+*   mapPutLast      - Same as mapPut, in constant time when the key is bigger
+*                    than all the keys in the map (for building a map from
+*                    sorted pairs).
 *   mapGet  	    - Returns the data paired to a key which matches the given key.
 *					  Iterator status unchanged
 *   mapRemove		- Removes a pair of (key,data) elements for which the key
@@ -30,9 +43,24 @@
 *   				  map, and returns it.
 *   mapGetNext		- Advances the internal iterator to the next key and
 *   				  returns it.
+*   mapIteratorFirst - Sets an external iterator to the first pair of the map
+*                    and returns its key.
+*   mapIteratorNext - Advances an external iterator and returns the next key.
+*   mapIteratorGetData - Returns the data paired to the key an external
+*                    iterator is on.
 *	 mapClear		- Clears the contents of the map. Frees all the elements of
 *	 				  the map using the free function.
+*   mapGetAllocatorStats - Returns the node allocation statistics of a map
 * 	 MAP_FOREACH	- A macro for iterating over the map's elements.
+*   MAP_FOREACH_ITERATOR - A macro for iterating over the map's elements with
+*                    an external iterator.
+*
+* External iterators (MapIterator) are independent of the internal iterator
+* and of each other, so several loops can go over the same map at once,
+* nested or from different threads, as long as the map isn't changed during
+* the loops. Functions that don't change the map and don't use the internal
+* iterator (mapGet, mapContains, mapGetSize and the external iterator
+* functions) can be called from several threads at the same time.
 */
 
 /** Type for defining the map */
@@ -47,6 +75,18 @@ typedef enum MapResult_t {
     MAP_ITEM_DOES_NOT_EXIST
 } MapResult;
 
+/** Type used for choosing the data structure behind a map */
+typedef enum MapBackend_t {
+    MAP_BACKEND_SORTED_LIST,    // O(n) lookup and insert, smallest memory footprint
+    MAP_BACKEND_SKIP_LIST       // O(log n) expected lookup and insert
+} MapBackend;
+
+/** External iterator over a map, usually declared on the stack.
+ *  Its field is private and must only be used through the iterator functions. */
+typedef struct MapIterator_t {
+    struct MapNode_t *node;     // the pair the iterator is on, NULL at the end of the map
+} MapIterator;
+
 /** Data element data type for map container */
 typedef void *MapDataElement;
 
@@ -98,6 +138,53 @@ Map mapCreate(copyMapDataElements copyDataElement,
               freeMapKeyElements freeKeyElement,
               compareMapKeyElements compareKeyElements);
 
+/**
+* mapCreateWithBackend: Allocates a new empty map using the given backend.
+* mapCreate is the same as calling this function with MAP_BACKEND_SORTED_LIST.
+*
+* @param copyDataElement, copyKeyElement, freeDataElement, freeKeyElement,
+*   compareKeyElements - Same as in mapCreate
+* @param backend - The data structure used for storing the pairs
+* @return
+* 	NULL - if one of the parameters is NULL or allocations failed.
+* 	A new Map in case of success.
+*/
+Map mapCreateWithBackend(copyMapDataElements copyDataElement,
+                         copyMapKeyElements copyKeyElement,
+                         freeMapDataElements freeDataElement,
+                         freeMapKeyElements freeKeyElement,
+                         compareMapKeyElements compareKeyElements,
+                         MapBackend backend);
+
+/**
+* mapCreatePooled: Allocates a new empty map using the given backend, that
+* allocates its nodes from pools instead of one malloc per node.
+* Keys and data of a fixed size can be kept inline: they're copied into the
+* node with memcpy and released with it, so no copy or free function is
+* called for them. Pointers to inline elements (returned by mapGet,
+* mapGetFirst, etc.) are valid until their pair is removed.
+* Clearing or destroying the map returns all of its nodes at once, without
+* going over them if both the keys and the data are inline.
+*
+* @param copyDataElement, copyKeyElement, freeDataElement, freeKeyElement,
+*   compareKeyElements - Same as in mapCreate. The copy and free functions
+*   of inline elements may be NULL.
+* @param backend - The data structure used for storing the pairs
+* @param keySize - Size of an inline key in bytes, 0 if keys are copied with
+*   copyKeyElement
+* @param dataSize - Size of inline data in bytes, 0 if data is copied with
+*   copyDataElement
+* @return
+* 	NULL - if one of the needed parameters is NULL or allocations failed.
+* 	A new Map in case of success.
+*/
+Map mapCreatePooled(copyMapDataElements copyDataElement,
+                    copyMapKeyElements copyKeyElement,
+                    freeMapDataElements freeDataElement,
+                    freeMapKeyElements freeKeyElement,
+                    compareMapKeyElements compareKeyElements,
+                    MapBackend backend, size_t keySize, size_t dataSize);
+
 /**
 * mapDestroy: Deallocates an existing map. Clears all elements by using the
 * stored free functions.
@@ -108,7 +195,7 @@ Map mapCreate(copyMapDataElements copyDataElement,
 void mapDestroy(Map map);
 
 /**
-* mapCopy: Creates a copy of target map.
+* mapCopy: Creates a copy of target map. The copy uses the same backend.
 * Iterator values for both maps is undefined after this operation.
 *
 * @param map - Target map.
@@ -119,7 +206,8 @@ void mapDestroy(Map map);
 Map mapCopy(Map map);
 
 /**
-* mapGetSize: Returns the number of elements in a map
+* mapGetSize: Returns the number of elements in a map.
+* The size is tracked on every insertion and removal, so this takes constant time.
 * @param map - The map which size is requested
 * @return
 * 	-1 if a NULL pointer was sent.
@@ -159,6 +247,45 @@ bool mapContains(Map map, MapKeyElement element);
 */
 MapResult mapPut(Map map, MapKeyElement keyElement, MapDataElement dataElement);
 
+/**
+*	mapPutMove: Gives a specified key a specific value, taking ownership of the
+*	given key and data instead of copying them.
+*	On success the map frees them with the stored free functions when they're
+*	no longer needed: the data when its pair is removed or its value is
+*	overridden, and the key right away if it already exists in the map.
+*	Inline elements (see mapCreatePooled) are copied into the node, and stay
+*	owned by the caller.
+*  Iterator's value is undefined after this operation.
+*
+* @param map - The map for which to reassign the data element
+* @param keyElement - The key element which need to be reassigned
+* @param dataElement - The new data element to associate with the given key.
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map, keyElement or dataElement
+* 	MAP_OUT_OF_MEMORY if an allocation failed. The map is unchanged and the
+* 	caller still owns the key and data.
+* 	MAP_SUCCESS the paired elements had been inserted successfully
+*/
+MapResult mapPutMove(Map map, MapKeyElement keyElement, MapDataElement dataElement);
+
+/**
+*	mapPutLast: Gives a specified key a specific value, like mapPut.
+*	When the key is bigger than all the keys in the map, the pair is added at
+*	the end of the map without searching for its place, so building a map from
+*	pairs sorted by key takes linear time. Otherwise it's the same as mapPut.
+*  Iterator's value is undefined after this operation.
+*
+* @param map - The map for which to reassign the data element
+* @param keyElement - The key element which need to be reassigned
+* @param dataElement - The new data element to associate with the given key.
+*      A copy of the element will be inserted as supplied by the copying function.
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map, keyElement or dataElement
+* 	MAP_OUT_OF_MEMORY if an allocation failed
+* 	MAP_SUCCESS the paired elements had been inserted successfully
+*/
+MapResult mapPutLast(Map map, MapKeyElement keyElement, MapDataElement dataElement);
+
 /**
 *	mapGet: Returns the data associated with a specific key in the map.
 *			Iterator status unchanged
@@ -230,6 +357,50 @@ MapKeyElement mapGetNext(Map map);
 */
 MapResult mapClear(Map map);
 
+/**
+* mapGetAllocatorStats: Returns the statistics of the node allocations of a
+* map since it was created. For a map that isn't pooled every node is one
+* system allocation. Allocations made by the copy functions aren't counted.
+* @param map - The map
+* @param stats - Set to the map's statistics
+* @return
+* 	MAP_NULL_ARGUMENT - if a NULL pointer was sent.
+* 	MAP_SUCCESS - Otherwise.
+*/
+MapResult mapGetAllocatorStats(Map map, PoolStats *stats);
+
+/**
+*	mapIteratorFirst: Sets an external iterator to the first pair of the map
+*	and returns its key. The map's internal iterator is unchanged.
+* @param map - The map to iterate over
+* @param iterator - The iterator to set
+* @return
+* 	NULL if a NULL pointer was sent or the map is empty.
+* 	The first key element of the map otherwise.
+*/
+MapKeyElement mapIteratorFirst(Map map, MapIterator *iterator);
+
+/**
+*	mapIteratorNext: Advances an external iterator to the next pair and returns
+*	its key. The iterator is invalid once the map is changed.
+* @param iterator - The iterator to advance
+* @return
+* 	NULL if reached the end of the map, the iterator was already at the end
+* 	or a NULL sent as argument.
+* 	The next key element of the map otherwise.
+*/
+MapKeyElement mapIteratorNext(MapIterator *iterator);
+
+/**
+*	mapIteratorGetData: Returns the data element paired to the key an external
+*	iterator is on.
+* @param iterator - The iterator
+* @return
+* 	NULL if the iterator is at the end of the map or a NULL sent as argument.
+* 	The data element paired to the current key otherwise.
+*/
+MapDataElement mapIteratorGetData(MapIterator *iterator);
+
 /*!
 * Macro for iterating over a map.
 * Declares a new iterator for the loop.
@@ -239,4 +410,15 @@ MapResult mapClear(Map map);
         iterator ;\
         iterator = mapGetNext(map))
 
+/*!
+* Macro for iterating over a map with an external iterator (a MapIterator
+* declared by the caller), the data of the current pair is given by
+* mapIteratorGetData(&mapIterator).
+* Declares a new key variable for the loop.
+*/
+#define MAP_FOREACH_ITERATOR(type, key, map, mapIterator) \
+    for(type key = (type) mapIteratorFirst(map, &(mapIterator)) ; \
+        key ;\
+        key = (type) mapIteratorNext(&(mapIterator)))
+
 #endif /* MAP_H_ */
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "points.h"
+
+/**
+ * Implementation of points.h
+ */
+
+struct PointVector_t {
+    StatePoints *elements;
+    int size;
+};
+
+/************************* HELP FUNCTIONS DECLARATIONS (STATIC) *******************************/
+/**
+ * compare function for qsort: negative if the first state ranks higher, positive otherwise
+ * (never 0, IDs are unique)
+ */
+static int compareStatePointsElements(const void *element1, const void *element2);
+
+/**
+ * Reorders an array so the state that ranks in a given place is in that place,
+ * the higher ranking states are before it and the lower ranking states after it
+ * (in any order). Takes linear time on average.
+ * @param elements - The array
+ * @param size - The number of elements in the array
+ * @param place - The place to fix (0 for the highest ranking state)
+ */
+static void selectPlace(StatePoints *elements, int size, int place);
+
+/************************* POINT VECTOR FUNCTIONS *******************************/
+PointVector pointVectorCreate(int size) {
+    assert(size >= 0);
+
+    PointVector vector = malloc(sizeof(*vector));
+    if (!vector) return NULL;
+
+    // allocate at least one element, so an empty vector is allocated as well
+    vector->elements = malloc(sizeof(*vector->elements) * (size > 0 ? size : 1));
+    if (!vector->elements) {
+        free(vector);
+        return NULL;
+    }
+    vector->size = size;
+
+    return vector;
+}
+
+PointVector pointVectorCopy(PointVector vector) {
+    if (!vector) return NULL;
+
+    PointVector copy = pointVectorCreate(vector->size);
+    if (!copy) return NULL;
+
+    // copy all the elements at once
+    memcpy(copy->elements, vector->elements, sizeof(*vector->elements) * vector->size);
+
+    return copy;
+}
+
+void pointVectorDestroy(PointVector vector) {
+    if (vector) {
+        free(vector->elements);
+        free(vector);
+    }
+}
+
+int pointVectorGetSize(PointVector vector) {
+    if (!vector) return -1;
+    return vector->size;
+}
+
+StatePoints *pointVectorGetData(PointVector vector) {
+    assert(vector != NULL);
+    return vector->elements;
+}
+
+bool statePointsRanksHigher(StatePoints points1, StatePoints points2) {
+    if (points1.points != points2.points) return points1.points > points2.points;
+    return points1.id < points2.id;     // IDs are always different
+}
+
+void pointVectorSort(PointVector vector) {
+    assert(vector != NULL);
+    qsort(vector->elements, vector->size, sizeof(*vector->elements), compareStatePointsElements);
+}
+
+void pointVectorPartialSort(PointVector vector, int k) {
+    assert(vector != NULL);
+
+    if (k >= vector->size) {
+        pointVectorSort(vector);
+        return;
+    }
+    if (k <= 0) return;     // nothing to sort
+
+    // move the k highest ranking states to the start, then sort only them
+    selectPlace(vector->elements, vector->size, k - 1);
+    qsort(vector->elements, k, sizeof(*vector->elements), compareStatePointsElements);
+}
+
+/************************* HELP FUNCTIONS IMPLEMENTATION *******************************/
+static int compareStatePointsElements(const void *element1, const void *element2) {
+    const StatePoints *points1 = element1, *points2 = element2;
+    return statePointsRanksHigher(*points1, *points2) ? -1 : 1;
+}
+
+static void selectPlace(StatePoints *elements, int size, int place) {
+    int low = 0, high = size - 1;
+
+    // the state of the given place is in [low, high]
+    while (low < high) {
+        StatePoints pivot = elements[low + (high - low) / 2];
+
+        // split [low, high] to the states that rank higher than the pivot and the ones that rank lower
+        int i = low, j = high;
+        while (i <= j) {
+            while (statePointsRanksHigher(elements[i], pivot)) i++;
+            while (statePointsRanksHigher(pivot, elements[j])) j--;
+            if (i <= j) {
+                StatePoints temp = elements[i];
+                elements[i] = elements[j];
+                elements[j] = temp;
+                i++;
+                j--;
+            }
+        }
+
+        // keep searching only in the part that contains the place
+        if (place <= j) {
+            high = j;
+        } else if (place >= i) {
+            low = i;
+        } else {
+            break;      // the place is between the parts, it holds the pivot
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef POINTS_H
+#define POINTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ *  File containing all macros, enums, structs and functions
+ *  related to the points the states get in a contest.
+ *
+ *  The points of all the states are kept in one contiguous array of (id, points) elements,
+ *  allocated once for the whole contest, so the scoring needs no allocation per state
+ *  and sorting the states moves the elements in place.
+ *  Points are exact integers (see calculateFinalPoints), so equal scores are always
+ *  equal and the ranking is the same on every run.
+ */
+
+/********************** MACROS, ENUMS & STRUCTS ***********************/
+/** the points a state gets */
+typedef struct StatePoints_t {
+    int id;         // ID of the state
+    int64_t points;
+} StatePoints;
+
+/** the points of a group of states */
+typedef struct PointVector_t *PointVector;
+
+/************************* POINT VECTOR FUNCTIONS *******************************/
+/***
+ * Creates a vector of the points of a given number of states.
+ * The elements aren't initialized.
+ * @param size - The number of states
+ * @return
+ *   NULL if a memory allocation failed
+ *   A new vector of size elements otherwise
+ */
+PointVector pointVectorCreate(int size);
+
+/***
+ * Creates a copy of a point vector.
+ * @param vector - The vector to copy
+ * @return
+ *   NULL if NULL was sent or a memory allocation failed
+ *   A new vector with the same elements otherwise
+ */
+PointVector pointVectorCopy(PointVector vector);
+
+/***
+ * Deallocates a point vector. If vector is NULL nothing is done.
+ * @param vector - The vector to deallocate
+ */
+void pointVectorDestroy(PointVector vector);
+
+/***
+ * Get the number of states in the vector
+ * @param vector - The vector
+ * @return -1 if NULL was sent, the number of elements otherwise
+ */
+int pointVectorGetSize(PointVector vector);
+
+/***
+ * Get the elements of the vector, which can be read and changed in place.
+ * The array is valid until the vector is destroyed.
+ * @param vector - The vector
+ * @return Array of pointVectorGetSize(vector) elements
+ */
+StatePoints *pointVectorGetData(PointVector vector);
+
+/***
+ * Checks if a state ranks higher than another one:
+ * more points, or the same points and a smaller ID.
+ * @param points1 - The first state's points
+ * @param points2 - The second state's points
+ * @return true if the first state ranks higher, false otherwise
+ */
+bool statePointsRanksHigher(StatePoints points1, StatePoints points2);
+
+/***
+ * Sorts the vector in place, from the highest ranking state to the lowest
+ * (see statePointsRanksHigher).
+ * @param vector - The vector to sort
+ */
+void pointVectorSort(PointVector vector);
+
+/***
+ * Partially sorts the vector in place: the k highest ranking states are moved
+ * to the start of the vector and sorted, the order of the rest is undefined.
+ * Costs less than sorting the whole vector when k is small.
+ * @param vector - The vector to sort
+ * @param k - The number of states to sort (the whole vector is sorted if it's bigger than its size)
+ */
+void pointVectorPartialSort(PointVector vector, int k);
+
+#endif //POINTS_H
@@ -0,0 +1,160 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "pool.h"
+
+/********************** ENUMS & STRUCTS ***********************/
+/** union of the basic types with the strictest alignment, used for aligning blocks
+ *  (long double needs 16 bytes on x86-64, so blocks are aligned like malloc's) */
+typedef union PoolAlign_t {
+    long long integer;
+    long double floating;
+    void *pointer;
+    void (*function)(void);
+} PoolAlign;
+
+/** slab header, the slab's blocks follow it */
+typedef struct PoolSlab_t {
+    struct PoolSlab_t *next;
+    PoolAlign blocks[];     // keeps the blocks after the header aligned
+} *PoolSlab;
+
+/** free block, linked through its first bytes */
+typedef struct PoolBlock_t {
+    struct PoolBlock_t *next;
+} *PoolBlock;
+
+/** pool struct */
+struct Pool_t {
+    size_t block_size;      // rounded up to keep every block aligned
+    int blocks_per_slab;
+    PoolSlab slabs;         // all the slabs allocated so far
+    PoolBlock free_blocks;  // blocks that were freed and can be reused
+    char *unused;           // next block of the newest slab that was never handed out
+    int unused_count;       // number of such blocks
+    PoolStats stats;
+};
+
+/*************** HELP FUNCTIONS DECLARATIONS ****************/
+/** Allocates a new slab and makes its blocks the pool's unused blocks
+ * @return false if the allocation failed, true otherwise
+ */
+static bool poolAddSlab(Pool pool);
+
+/** Releases all the slabs of the pool */
+static void poolReleaseSlabs(Pool pool);
+
+/********************** POOL FUNCTIONS ***********************/
+Pool poolCreate(size_t block_size, int blocks_per_slab) {
+    if (block_size == 0 || blocks_per_slab <= 0) return NULL;
+
+    Pool pool = malloc(sizeof(*pool));
+    if (!pool) return NULL;
+
+    // each block must fit a free list link, and be a multiple of the alignment
+    if (block_size < sizeof(struct PoolBlock_t)) {
+        block_size = sizeof(struct PoolBlock_t);
+    }
+    pool->block_size = poolRoundSize(block_size);
+
+    pool->blocks_per_slab = blocks_per_slab;
+    pool->slabs = NULL;
+    pool->free_blocks = NULL;
+    pool->unused = NULL;
+    pool->unused_count = 0;
+
+    pool->stats.allocations = 0;
+    pool->stats.releases = 0;
+    pool->stats.system_allocations = 0;
+    pool->stats.system_releases = 0;
+
+    return pool;
+}
+
+void poolDestroy(Pool pool) {
+    if (pool) {
+        poolReleaseSlabs(pool);
+        free(pool);
+    }
+}
+
+void *poolAlloc(Pool pool) {
+    if (!pool) return NULL;
+
+    void *block;
+    if (pool->free_blocks) {
+        // reuse a freed block
+        block = pool->free_blocks;
+        pool->free_blocks = pool->free_blocks->next;
+    } else {
+        // take the next unused block, allocate a new slab if there are none
+        if (pool->unused_count == 0 && !poolAddSlab(pool)) return NULL;
+
+        block = pool->unused;
+        pool->unused += pool->block_size;
+        pool->unused_count--;
+    }
+
+    pool->stats.allocations++;
+    return block;
+}
+
+void poolFree(Pool pool, void *block) {
+    if (!pool || !block) return;
+
+    // link the block to the free blocks
+    PoolBlock free_block = block;
+    free_block->next = pool->free_blocks;
+    pool->free_blocks = free_block;
+
+    pool->stats.releases++;
+}
+
+void poolClear(Pool pool) {
+    if (!pool) return;
+
+    // every block that's still allocated is released with its slab
+    pool->stats.releases = pool->stats.allocations;
+    poolReleaseSlabs(pool);
+}
+
+PoolStats poolGetStats(Pool pool) {
+    if (!pool) {
+        PoolStats empty = { 0, 0, 0, 0 };
+        return empty;
+    }
+    return pool->stats;
+}
+
+size_t poolRoundSize(size_t size) {
+    return (size + sizeof(PoolAlign) - 1) / sizeof(PoolAlign) * sizeof(PoolAlign);
+}
+
+/****************** HELP FUNCTIONS IMPLEMENTATIONS *******************/
+static bool poolAddSlab(Pool pool) {
+    PoolSlab slab = malloc(sizeof(*slab) + pool->block_size * pool->blocks_per_slab);
+    if (!slab) return false;
+
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    pool->unused = (char *)slab->blocks;
+    pool->unused_count = pool->blocks_per_slab;
+
+    pool->stats.system_allocations++;
+    return true;
+}
+
+static void poolReleaseSlabs(Pool pool) {
+    PoolSlab slab = pool->slabs;
+    while (slab != NULL) {
+        PoolSlab next = slab->next;
+        free(slab);
+        pool->stats.system_releases++;
+        slab = next;
+    }
+
+    pool->slabs = NULL;
+    pool->free_blocks = NULL;
+    pool->unused = NULL;
+    pool->unused_count = 0;
+}
@@ -0,0 +1,102 @@
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <stddef.h>
+
+/**
+* Fixed-Size Block Pool
+*
+* Hands out blocks of one fixed size, carved from large slabs.
+* A freed block is kept for the next allocation instead of being returned
+* to the system, and all the slabs are released together when the pool is
+* cleared or destroyed. This turns many small mallocs and frees into a few
+* bulk ones.
+*
+* The following functions are available:
+*   poolCreate		- Creates a new empty pool
+*   poolDestroy	- Deletes a pool and releases all its slabs
+*   poolAlloc		- Allocates a block from the pool
+*   poolFree		- Returns a block to the pool
+*   poolClear		- Returns all the blocks to the pool at once
+*   poolGetStats	- Returns the allocation statistics of the pool
+*   poolRoundSize	- Rounds a size up to the alignment of the blocks
+*/
+
+/** Type for defining the pool */
+typedef struct Pool_t *Pool;
+
+/** Allocation statistics of a pool (counted since it was created) */
+typedef struct PoolStats_t {
+    long allocations;           // blocks handed out by poolAlloc
+    long releases;              // blocks returned by poolFree or poolClear
+    long system_allocations;    // calls to malloc (one per slab)
+    long system_releases;       // calls to free (one per slab)
+} PoolStats;
+
+/**
+* poolCreate: Allocates a new empty pool. No slab is allocated until the first
+* block is.
+*
+* @param block_size - Size of each block in bytes
+* @param blocks_per_slab - Number of blocks allocated together in each slab
+* @return
+* 	NULL - if one of the parameters is 0 or the allocation failed.
+* 	A new Pool in case of success.
+*/
+Pool poolCreate(size_t block_size, int blocks_per_slab);
+
+/**
+* poolDestroy: Releases all the slabs of a pool and deallocates it.
+* All the blocks of the pool become invalid.
+*
+* @param pool - Target pool to be deallocated. If pool is NULL nothing will be
+* 		done
+*/
+void poolDestroy(Pool pool);
+
+/**
+* poolAlloc: Allocates a block of the pool's block size.
+* The block is aligned for any basic type.
+*
+* @param pool - The pool to allocate from
+* @return
+* 	NULL if a NULL was sent or a slab allocation failed.
+* 	A pointer to the block otherwise.
+*/
+void *poolAlloc(Pool pool);
+
+/**
+* poolFree: Returns a block to the pool so it can be allocated again.
+*
+* @param pool - The pool the block was allocated from
+* @param block - The block to return. If block is NULL nothing will be done
+*/
+void poolFree(Pool pool, void *block);
+
+/**
+* poolClear: Returns all the blocks of the pool at once and releases its slabs.
+* All the blocks of the pool become invalid.
+*
+* @param pool - Target pool. If pool is NULL nothing will be done
+*/
+void poolClear(Pool pool);
+
+/**
+* poolGetStats: Returns the allocation statistics of the pool.
+*
+* @param pool - The pool
+* @return The pool's statistics (all zero if a NULL was sent)
+*/
+PoolStats poolGetStats(Pool pool);
+
+/**
+* poolRoundSize: Rounds a size up to a multiple of the alignment of the
+* pool's blocks, so anything placed at that offset inside a block is aligned
+* for any basic type as well.
+*
+* @param size - The size to round
+* @return The smallest multiple of the alignment that isn't smaller than size
+*/
+size_t poolRoundSize(size_t size);
+
+#endif /* POOL_H_ */
@@ -14,52 +14,52 @@
  * Implementation of state.h
  */
 
-struct StateData_t {
+/** the names of a state, which never change (so all the copies of the state share them) */
+typedef struct stateNames_t {
+    int references;     // number of StateData structs that use the names (not atomic, see eurovisionClone)
     char *name;
     char *song_name;
-    Map votes; // key = State's ID, data = no. of votes this state *gives*
-};
+} *StateNames;
 
-/************************* VOTE MAP DEFINITIONS AND FUNCTION DECLARATIONS (STATIC) *******************************/
-typedef void* VoteKeyElement;
-typedef void* VoteDataElement;
+/** the votes of a state and who votes for it and ranked it, shared by the copies of the state
+ *  until one of them changes (see stateMakeWritable) */
+typedef struct stateBallots_t {
+    int references;     // number of StateData structs that use the ballots (not atomic either)
+    Votes votes; // the votes this state *gives*, sorted by the IDs of the states that receive them
+    IntIntMap givers;  // the states that vote for this state (giver ID -> number of votes)
+    IntIntMap judges;  // the judges that ranked this state (judge ID -> place in the judge's results)
+} *StateBallots;
 
+struct StateData_t {
+    StateNames names;       // shared, the friendly pairs point to the names so they're never copied
+    StateBallots ballots;   // shared until the state is made writable
+    int audience_points;    // points this state *gets* from the other states' rankings
+    int judge_points;       // points this state *gets* from the judges' results
+};
+
+/************************* HELP FUNCTIONS DECLARATIONS (STATIC) *******************************/
 /**
- * Copy function for the key element in the Votes map.
- * @param key - ID of the state that receives the votes
- * @return A copy of the state ID
+ * Creates the names of a state.
+ * @return NULL if a memory allocation failed, the new names (with one reference) otherwise
  */
-static VoteKeyElement copyVoteKeyElement(VoteKeyElement key);
+static StateNames stateNamesCreate(const char *state_name, const char *song_name);
 
 /**
- * Copy function for the data element in the Votes map.
- * @param data - The amount of votes to give
- * @return A copy of the amount of votes
+ * Drops a reference to the names of a state, and deallocates them if it was the last one.
  */
-
-static VoteDataElement copyVoteDataElement(VoteDataElement data);
+static void stateNamesRelease(StateNames names);
 
 /**
- * Function for deallocating the key element in the Votes map.
- * @param key - ID of the state that receives the votes
+ * Creates the ballots of a state from given votes, givers and judges (which they take).
+ * @return NULL if a memory allocation failed (nothing is deallocated),
+ *   the new ballots (with one reference) otherwise
  */
-static void freeVoteKeyElement(VoteKeyElement key);
+static StateBallots stateBallotsCreate(Votes votes, IntIntMap givers, IntIntMap judges);
+
 /**
- * Function for deallocating the data element in the Votes map.
- * @param data - The amount of votes to give
+ * Drops a reference to the ballots of a state, and deallocates them if it was the last one.
  */
-static void freeVoteDataElement(VoteDataElement data);
-
-/***
- * Compare function for two keys in Votes map.
- * @param key1 - A state's ID
- * @param key2 - A state's ID
- * @return
- *   Positive integer if first key is bigger than the second
- *   Negative integer if first key is smaller than the second
- *   0 if keys are equal
- */
-static int compareVoteKeyElements(VoteKeyElement key1, VoteKeyElement key2);
+static void stateBallotsRelease(StateBallots ballots);
 
 /************************* STATE MAP FUNCTIONS *******************************/
 StateKeyElement copyStateKeyElement(StateKeyElement key) {
@@ -73,33 +73,15 @@ StateDataElement copyStateDataElement(StateDataElement data) {
     StateData copy = malloc(sizeof(*copy));
     if (!copy) return NULL;
 
-    // allocate memory for state's name
-    copy->name = malloc(strlen(state_data->name) + 1);
-    if (!copy->name) {
-        free(copy);
-        return NULL;
-    }
+    // share the names and the ballots, they're copied only when one of the copies changes them
+    copy->names = state_data->names;
+    copy->names->references++;
+    copy->ballots = state_data->ballots;
+    copy->ballots->references++;
 
-    // allocate memory for state's song name
-    copy->song_name = malloc(strlen(state_data->song_name) + 1);
-    if (!copy->song_name) {
-        free(copy->name);
-        free(copy);
-        return NULL;
-    }
-
-    // copy the State's votes map
-    copy->votes = mapCopy(state_data->votes);
-    if(!copy->votes) {
-        free(copy->name);
-        free(copy->song_name);
-        free(copy);
-        return NULL;
-    }
-
-    // copy the state's name and song name
-    strcpy(copy->name, state_data->name);
-    strcpy(copy->song_name, state_data->song_name);
+    // copy the state's points
+    copy->audience_points = state_data->audience_points;
+    copy->judge_points = state_data->judge_points;
 
     return copy;
 }
@@ -111,11 +93,9 @@ void freeStateKeyElement(StateKeyElement key) {
 void freeStateDataElement(StateDataElement data) {
     StateData state_data = (StateData)data;
 
-    mapDestroy(state_data->votes); // free the state's votes map
-
-    // deallocate state's name and song name
-    free(state_data->name);
-    free(state_data->song_name);
+    // the names and ballots are deallocated only if no other copy of the state uses them
+    stateNamesRelease(state_data->names);
+    stateBallotsRelease(state_data->ballots);
 
     free(state_data);               // deallocate the stateData struct
 }
@@ -126,94 +106,153 @@ int compareStateKeyElements(StateKeyElement key1, StateKeyElement key2) {
 
 /************************* STATE DATA FUNCTIONS *******************************/
 StateData stateDataCreate(const char *state_name, const char *song_name) {
-    // allocate memory for a StateData struct as well as the state's name and song name
+    // allocate memory for a StateData struct as well as the state's names and ballots
     // on each allocation check if allocation failed
     StateData data = malloc(sizeof(*data));
     if (!data) return NULL;
 
-    char *name = malloc(strlen(state_name) + 1);
-    if (!name) {
-        free(data);
-        return NULL;
-    }
-
-    char *song = malloc(strlen(song_name) + 1);
-    if (!song) {
+    StateNames names = stateNamesCreate(state_name, song_name);
+    if (!names) {
         free(data);
-        free(name);
         return NULL;
     }
 
-    // Create an empty votes map using appropriate vote copy, free and compare functions
-    Map votes = mapCreate(copyVoteDataElement,
-                          copyVoteKeyElement,
-                          freeVoteDataElement,
-                          freeVoteKeyElement,
-                          compareVoteKeyElements);
-    if (!votes) {
+    // Create an empty votes row and empty givers and judges maps
+    // (IDs and values are kept inline in sorted arrays)
+    Votes votes = votesCreate();
+    IntIntMap givers = intIntMapCreate();
+    IntIntMap judges = intIntMapCreate();
+    StateBallots ballots = (votes && givers && judges) ? stateBallotsCreate(votes, givers, judges) : NULL;
+    if (!ballots) {
+        votesDestroy(votes);
+        intIntMapDestroy(givers);
+        intIntMapDestroy(judges);
+        stateNamesRelease(names);
         free(data);
-        free(name);
-        free(song);
         return NULL;
     }
 
-    // copy the state and song names
-    strcpy(name, state_name);
-    strcpy(song, song_name);
-
     // set the StateData's fields accordingly
-    data->name = name;
-    data->song_name = song;
-    data->votes = votes;
+    data->names = names;
+    data->ballots = ballots;
+    data->audience_points = 0;
+    data->judge_points = 0;
 
     return data;
 }
 
+bool stateMakeWritable(StateData data) {
+    StateBallots shared = data->ballots;
+    if (shared->references == 1) return true;     // only this state uses its ballots
+
+    // copy the votes, givers and judges for this state alone
+    Votes votes = votesCopy(shared->votes);
+    IntIntMap givers = intIntMapCopy(shared->givers);
+    IntIntMap judges = intIntMapCopy(shared->judges);
+    StateBallots ballots = (votes && givers && judges) ? stateBallotsCreate(votes, givers, judges) : NULL;
+    if (!ballots) {
+        votesDestroy(votes);
+        intIntMapDestroy(givers);
+        intIntMapDestroy(judges);
+        return false;
+    }
+
+    // the other copies keep the shared ballots
+    stateBallotsRelease(shared);
+    data->ballots = ballots;
+
+    return true;
+}
+
 char *stateGetName(StateData data) {
-    return data->name;
+    return data->names->name;
+}
+
+Votes stateGetVotes(StateData data) {
+    return data->ballots->votes;
+}
+
+IntIntMap stateGetGivers(StateData data) {
+    return data->ballots->givers;
+}
+
+IntIntMap stateGetJudges(StateData data) {
+    return data->ballots->judges;
+}
+
+int stateGetAudiencePoints(StateData data) {
+    return data->audience_points;
+}
+
+int stateGetJudgePoints(StateData data) {
+    return data->judge_points;
 }
 
-Map stateGetVotes(StateData data) {
-    return data->votes;
+void stateAddAudiencePoints(StateData data, int points) {
+    data->audience_points += points;
+}
+
+void stateAddJudgePoints(StateData data, int points) {
+    data->judge_points += points;
 }
 
 int stateGetFavorite(StateData state) {
-    Map votes = stateGetVotes(state);
+    Votes votes = stateGetVotes(state);
 
     // no votes = no favorite state
-    if(mapGetSize(votes) <= 0) return NO_STATE;
-
-    VoteKeyElement favState = mapGetFirst(votes);   // state with max no. of votes
-    int max = *(int*)mapGet(votes, favState);       // max no. of votes
-    MAP_FOREACH(VoteKeyElement, state_id, votes) {
-        int num_of_votes = *(int*)mapGet(votes, state_id);
-        if (num_of_votes > max) {   // compare votes two state's receive
-            // update the most voted
-            favState = state_id;
-            max = num_of_votes;
-        }
-    }
+    if(votesGetRankingSize(votes) <= 0) return NO_STATE;
 
-    return *(int*)favState;     // ID of most voted state
+    // the state in the first place of the ranking got the most votes (the smallest ID on a tie)
+    return votesGetRanking(votes)[0].taker;
 }
 
-/************************* VOTE MAP FUNCTIONS IMPLEMENTATION *******************************/
-static VoteKeyElement copyVoteKeyElement(VoteKeyElement key) {
-    return copyInt(key);    // get a copy of the state_taker's ID
-}
+/************************* HELP FUNCTIONS IMPLEMENTATION *******************************/
+static StateNames stateNamesCreate(const char *state_name, const char *song_name) {
+    StateNames names = malloc(sizeof(*names));
+    if (!names) return NULL;
+
+    names->name = malloc(strlen(state_name) + 1);
+    names->song_name = malloc(strlen(song_name) + 1);
+    if (!names->name || !names->song_name) {
+        free(names->name);
+        free(names->song_name);
+        free(names);
+        return NULL;
+    }
 
-static VoteDataElement copyVoteDataElement(VoteDataElement data) {
-    return copyInt(data);   // get a copy of the no. of votes
+    // copy the state and song names
+    strcpy(names->name, state_name);
+    strcpy(names->song_name, song_name);
+    names->references = 1;
+
+    return names;
 }
 
-static void freeVoteKeyElement(VoteKeyElement key) {
-    freeInt(key);           // deallocate the state_taker's ID
+static void stateNamesRelease(StateNames names) {
+    if (--names->references > 0) return;   // another copy of the state still uses them
+
+    free(names->name);
+    free(names->song_name);
+    free(names);
 }
 
-static void freeVoteDataElement(VoteDataElement data) {
-    freeInt(data);          // deallocate the no. of votes
+static StateBallots stateBallotsCreate(Votes votes, IntIntMap givers, IntIntMap judges) {
+    StateBallots ballots = malloc(sizeof(*ballots));
+    if (!ballots) return NULL;
+
+    ballots->votes = votes;
+    ballots->givers = givers;
+    ballots->judges = judges;
+    ballots->references = 1;
+
+    return ballots;
 }
 
-static int compareVoteKeyElements(VoteKeyElement key1, VoteKeyElement key2) {
-    return compareInts(key1, key2);     // compare two state_takers' IDs
+static void stateBallotsRelease(StateBallots ballots) {
+    if (--ballots->references > 0) return;   // another copy of the state still uses them
+
+    votesDestroy(ballots->votes);       // free the state's votes
+    intIntMapDestroy(ballots->givers);  // free the state's givers
+    intIntMapDestroy(ballots->judges);  // free the state's judges
+    free(ballots);
 }
@@ -2,10 +2,17 @@
 #define STATES_H
 
 #include "list.h"
+#include "map.h"
+#include "intmap.h"
+#include "votes.h"
 
 /**
  *  File containing all macros, enums, structs and functions
  *  related to the States map and the data element in said map.
+ *
+ *  Copies of a state's data share its names, votes, givers and judges (copy-on-write),
+ *  so copying the States map of a whole contest copies only the points of each state.
+ *  The votes, givers and judges of a state may be changed only after stateMakeWritable.
  */
 
 /********************** MACROS & ENUMS ***********************/
@@ -32,8 +39,10 @@ StateKeyElement copyStateKeyElement(StateKeyElement key);
 
 /***
  * Copy function for the data element in States map.
- * @param data - StateData struct with state's name, song name and votes map
- * @return A copy of the StateData struct
+ * The copy shares the names, votes, givers and judges of data until one of them
+ * is made writable (see stateMakeWritable), only the points are copied.
+ * @param data - StateData struct with state's name, song name and votes
+ * @return A copy of the StateData struct, NULL if a memory allocation failed
  */
 StateDataElement copyStateDataElement(StateDataElement data);
 
@@ -71,6 +80,14 @@ int compareStateKeyElements(StateKeyElement key1, StateKeyElement key2);
  */
 StateData stateDataCreate(const char *state_name, const char *song_name);
 
+/***
+ * Makes the votes, givers and judges of the state its own, copying them if they're shared
+ * with another copy of the state. Must be called before changing any of them.
+ * @param data - State data element (StateData struct)
+ * @return false if a memory allocation failed (the state is unchanged), true otherwise
+ */
+bool stateMakeWritable(StateData data);
+
 /***
  * Get the state's name
  * @param data - State data element (StateData struct)
@@ -81,16 +98,60 @@ char *stateGetName(StateData data);
 /***
  * Get the votes the state gives
  * @param data - Data Element in State's map (StateData struct)
- * @return
+ * @return The state's votes row (see votes.h), changed only after stateMakeWritable
+ */
+Votes stateGetVotes(StateData data);
+
+/***
+ * Get the states that vote for the state
+ * @param data - State data element (StateData struct)
+ * @return Map of the IDs of the states that have the state in their votes
+ *   (key = giver's ID, value = the number of votes it gives the state)
+ */
+IntIntMap stateGetGivers(StateData data);
+
+/***
+ * Get the judges that ranked the state
+ * @param data - State data element (StateData struct)
+ * @return Map of the IDs of the judges that have the state in their results
+ *   (key = judge ID, value = the state's place in the judge's results)
+ */
+IntIntMap stateGetJudges(StateData data);
+
+/***
+ * Get the points the state got from the audience, as kept on the scoreboard
+ * @param data - State data element (StateData struct)
+ * @return The sum of the points the state got from the rankings of the other states
+ */
+int stateGetAudiencePoints(StateData data);
+
+/***
+ * Get the points the state got from the judges, as kept on the scoreboard
+ * @param data - State data element (StateData struct)
+ * @return The sum of the points the state got from the judges' results
+ */
+int stateGetJudgePoints(StateData data);
+
+/***
+ * Add to (or subtract from) the points the state got from the audience
+ * @param data - State data element (StateData struct)
+ * @param points - Number of points to add (negative to subtract)
+ */
+void stateAddAudiencePoints(StateData data, int points);
+
+/***
+ * Add to (or subtract from) the points the state got from the judges
+ * @param data - State data element (StateData struct)
+ * @param points - Number of points to add (negative to subtract)
  */
-Map stateGetVotes(StateData data);
+void stateAddJudgePoints(StateData data, int points);
 
 /**
  * A given state's favorite state
  * @param state - A state's data (name, song name and votes)
  * @return
  *   Returns the ID of the state which got the most votes
- *   in the given StateData's votes map
+ *   in the given StateData's votes (the smallest ID on a tie)
  */
 int stateGetFavorite(StateData state);
 
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include "votes.h"
+
+/**
+ * Implementation of votes.h
+ */
+
+struct Votes_t {
+    IntIntMap counts;       // taker ID -> number of votes, sorted by the takers' IDs
+    VoteEntry ranking[NUMBER_OF_RANKINGS];  // most voted states, from first place to last
+    int ranking_size;       // min(number of takers, NUMBER_OF_RANKINGS)
+};
+
+/************************* HELP FUNCTIONS DECLARATIONS (STATIC) *******************************/
+/**
+ * Packs the rank of an entry into one integer: an entry ranks higher than another one
+ * (more votes, or the same number of votes and a smaller ID) if and only if its key is bigger.
+ * The count is in the high half and the complement of the ID in the low half.
+ */
+static uint64_t entryRankKey(VoteEntry entry);
+
+/**
+ * Checks if an entry ranks higher than another one:
+ * more votes, or the same number of votes and a smaller ID.
+ */
+static bool entryRanksHigher(VoteEntry entry1, VoteEntry entry2);
+
+/**
+ * Updates the ranking after the number of votes given to a state changed.
+ * @param votes - The votes row, already updated
+ * @param taker - ID of the state that receives the votes
+ * @param count - The new number of votes (0 if the state was removed from the row)
+ * @param difference - The change in the number of votes
+ */
+static void votesUpdateRanking(Votes votes, int taker, int count, int difference);
+
+/**
+ * Rebuilds the ranking by going over all the entries of the row.
+ * @param votes - The votes row
+ */
+static void votesRebuildRanking(Votes votes);
+
+/************************* VOTES FUNCTIONS *******************************/
+Votes votesCreate() {
+    Votes votes = malloc(sizeof(*votes));
+    if (!votes) return NULL;
+
+    votes->counts = intIntMapCreate();
+    if (!votes->counts) {
+        free(votes);
+        return NULL;
+    }
+
+    votes->ranking_size = 0;
+
+    return votes;
+}
+
+Votes votesCopy(Votes votes) {
+    if (!votes) return NULL;
+
+    Votes copy = malloc(sizeof(*copy));
+    if (!copy) return NULL;
+
+    copy->counts = intIntMapCopy(votes->counts);
+    if (!copy->counts) {
+        free(copy);
+        return NULL;
+    }
+
+    // copy the ranking
+    memcpy(copy->ranking, votes->ranking, sizeof(*votes->ranking) * votes->ranking_size);
+    copy->ranking_size = votes->ranking_size;
+
+    return copy;
+}
+
+void votesDestroy(Votes votes) {
+    if (votes) {
+        intIntMapDestroy(votes->counts);
+        free(votes);
+    }
+}
+
+int votesGetSize(Votes votes) {
+    if (!votes) return -1;
+    return intIntMapGetSize(votes->counts);
+}
+
+IntIntMap votesGetCounts(Votes votes) {
+    assert(votes != NULL);
+    return votes->counts;
+}
+
+const VoteEntry *votesGetRanking(Votes votes) {
+    assert(votes != NULL);
+    return votes->ranking;
+}
+
+int votesGetRankingSize(Votes votes) {
+    assert(votes != NULL);
+    return votes->ranking_size;
+}
+
+int votesGetCount(Votes votes, int taker) {
+    assert(votes != NULL);
+
+    int *count = intIntMapGet(votes->counts, taker);
+    return count ? *count : 0;
+}
+
+VotesResult votesChange(Votes votes, int taker, int difference) {
+    if (!votes) return VOTES_NULL_ARGUMENT;
+
+    int *count = intIntMapGet(votes->counts, taker);
+    if (count) {
+        // if there are votes for this state already update the number of votes
+        *count += difference;
+        int new_count = *count;
+        if (new_count <= 0) {
+            intIntMapRemove(votes->counts, taker);  // no votes left, remove the entry
+            new_count = 0;
+        }
+        votesUpdateRanking(votes, taker, new_count, difference);
+        return VOTES_SUCCESS;
+    }
+
+    // if there are no votes and difference <= 0 nothing is done (no votes added or removed)
+    if (difference <= 0) return VOTES_SUCCESS;
+
+    if (intIntMapPut(votes->counts, taker, difference) != MAP_SUCCESS) return VOTES_OUT_OF_MEMORY;
+    votesUpdateRanking(votes, taker, difference, difference);
+
+    return VOTES_SUCCESS;
+}
+
+bool votesRemove(Votes votes, int taker) {
+    assert(votes != NULL);
+
+    int *count = intIntMapGet(votes->counts, taker);
+    if (!count) return false;
+
+    int removed_count = *count;
+    intIntMapRemove(votes->counts, taker);
+    votesUpdateRanking(votes, taker, 0, -removed_count);
+    return true;
+}
+
+/************************* HELP FUNCTIONS IMPLEMENTATION *******************************/
+static uint64_t entryRankKey(VoteEntry entry) {
+    // counts are positive and IDs aren't negative, so both fit in 32 bits
+    return ((uint64_t)(uint32_t)entry.count << 32) | (UINT32_MAX - (uint32_t)entry.taker);
+}
+
+static bool entryRanksHigher(VoteEntry entry1, VoteEntry entry2) {
+    return entryRankKey(entry1) > entryRankKey(entry2);     // IDs are always different
+}
+
+static void votesUpdateRanking(Votes votes, int taker, int count, int difference) {
+    VoteEntry *ranking = votes->ranking;
+    VoteEntry entry = { .taker = taker, .count = count };
+
+    // find the state in the ranking
+    int place = 0;
+    while (place < votes->ranking_size && ranking[place].taker != taker) {
+        place++;
+    }
+
+    if (difference < 0) {
+        if (place == votes->ranking_size) return;   // an unranked state lost votes, nothing changes
+
+        if (count == 0) {
+            // the best unranked state (if there's one) takes the free place
+            if (votesGetSize(votes) >= votes->ranking_size) {
+                votesRebuildRanking(votes);
+                return;
+            }
+            memmove(ranking + place, ranking + place + 1,
+                    sizeof(*ranking) * (votes->ranking_size - place - 1));
+            votes->ranking_size--;
+            return;
+        }
+
+        // the unranked states all rank lower than the last place, so while the state still
+        // ranks higher than the last place it only moves down inside the ranking
+        int last = votes->ranking_size - 1;
+        if (votesGetSize(votes) > votes->ranking_size &&
+            (place == last || !entryRanksHigher(entry, ranking[last]))) {
+            votesRebuildRanking(votes);     // an unranked state may rank higher now
+            return;
+        }
+        while (place + 1 < votes->ranking_size && entryRanksHigher(ranking[place + 1], entry)) {
+            ranking[place] = ranking[place + 1];
+            place++;
+        }
+        ranking[place] = entry;
+        return;
+    }
+
+    if (place == votes->ranking_size) {
+        // an unranked state got votes: it enters in the last place if there's room
+        // or if it ranks higher than the state in the last place
+        if (votes->ranking_size < NUMBER_OF_RANKINGS) {
+            votes->ranking_size++;
+        } else if (!entryRanksHigher(entry, ranking[place - 1])) {
+            return;
+        }
+        place = votes->ranking_size - 1;
+    }
+
+    // move the state up to its new place
+    while (place > 0 && entryRanksHigher(entry, ranking[place - 1])) {
+        ranking[place] = ranking[place - 1];
+        place--;
+    }
+    ranking[place] = entry;
+}
+
+static void votesRebuildRanking(Votes votes) {
+    VoteEntry *ranking = votes->ranking;
+    uint64_t keys[NUMBER_OF_RANKINGS];  // the rank keys of the ranked entries
+    int size = 0;
+
+    // insert each entry into the ranking if it ranks high enough.
+    // once the ranking is full, most entries rank lower than the last place
+    // and are skipped with a single integer comparison
+    uint64_t last_key = 0;              // key of the last place once the ranking is full
+    INT_MAP_FOREACH(IntIntMapEntry, pair, votes->counts) {
+        VoteEntry entry = { .taker = pair->key, .count = pair->data };
+        uint64_t key = entryRankKey(entry);
+        int place = size;
+
+        if (place == NUMBER_OF_RANKINGS) {
+            if (key <= last_key) continue;
+            place--;    // the last ranked entry drops out
+        } else {
+            size++;
+        }
+
+        while (place > 0 && key > keys[place - 1]) {
+            ranking[place] = ranking[place - 1];
+            keys[place] = keys[place - 1];
+            place--;
+        }
+        ranking[place] = entry;
+        keys[place] = key;
+
+        if (size == NUMBER_OF_RANKINGS) last_key = keys[NUMBER_OF_RANKINGS - 1];
+    }
+
+    votes->ranking_size = size;
+}
@@ -0,0 +1,119 @@
+#ifndef VOTES_H
+#define VOTES_H
+
+#include <stdbool.h>
+#include "intmap.h"
+#include "judge.h"     // for NUMBER_OF_RANKINGS
+
+/**
+ *  File containing all macros, enums, structs and functions
+ *  related to the votes a state gives.
+ *
+ *  The votes of a state are kept in an IntIntMap from the takers' IDs to the numbers
+ *  of votes (a compressed row of the votes matrix), along with the ranking of the
+ *  most voted states, which is updated on every change.
+ */
+
+/********************** MACROS, ENUMS & STRUCTS ***********************/
+/** enum for votes functions return result */
+typedef enum VotesResult_t {
+    VOTES_SUCCESS,
+    VOTES_NULL_ARGUMENT,
+    VOTES_OUT_OF_MEMORY
+} VotesResult;
+
+/** the number of votes a state gives to a single state (an entry of the ranking) */
+typedef struct VoteEntry_t {
+    int taker;  // ID of the state that receives the votes
+    int count;  // number of votes (always positive)
+} VoteEntry;
+
+/** the votes a state gives */
+typedef struct Votes_t *Votes;
+
+/************************* VOTES FUNCTIONS *******************************/
+/***
+ * Creates an empty votes row.
+ * @return
+ *   NULL if a memory allocation failed
+ *   A new empty votes row otherwise
+ */
+Votes votesCreate();
+
+/***
+ * Creates a copy of a votes row.
+ * @param votes - The votes row to copy
+ * @return
+ *   NULL if NULL was sent or a memory allocation failed
+ *   A new votes row with the same entries otherwise
+ */
+Votes votesCopy(Votes votes);
+
+/***
+ * Deallocates a votes row. If votes is NULL nothing is done.
+ * @param votes - The votes row to deallocate
+ */
+void votesDestroy(Votes votes);
+
+/***
+ * Get the number of states that receive votes in the row
+ * @param votes - The votes row
+ * @return -1 if NULL was sent, the number of entries otherwise
+ */
+int votesGetSize(Votes votes);
+
+/***
+ * Get the numbers of votes given to each state, sorted by the takers' IDs.
+ * The map belongs to the row and is only read (the row changes it in votesChange).
+ * @param votes - The votes row
+ * @return Map from the takers' IDs to the numbers of votes
+ */
+IntIntMap votesGetCounts(Votes votes);
+
+/***
+ * Get the ranking of the row: the entries of the states that got the most votes,
+ * from the most voted state to the least voted one (the smaller ID first on a tie).
+ * The array is valid until the row is changed.
+ * @param votes - The votes row
+ * @return Array of votesGetRankingSize(votes) entries
+ */
+const VoteEntry *votesGetRanking(Votes votes);
+
+/***
+ * Get the number of entries in the ranking of the row
+ * @param votes - The votes row
+ * @return The smaller of NUMBER_OF_RANKINGS and votesGetSize(votes)
+ */
+int votesGetRankingSize(Votes votes);
+
+/***
+ * Get the number of votes given to a state
+ * @param votes - The votes row
+ * @param taker - ID of the state that receives the votes
+ * @return The number of votes (0 if there are none)
+ */
+int votesGetCount(Votes votes, int taker);
+
+/***
+ * Change the number of votes given to a state by a given difference.
+ * If the number of votes drops to zero or less, the state is removed from the row.
+ * If the state has no votes and difference isn't positive, nothing is done.
+ * @param votes - The votes row
+ * @param taker - ID of the state that receives the votes
+ * @param difference - Number of votes to add (negative to remove votes)
+ * @return
+ *   VOTES_NULL_ARGUMENT if votes is NULL
+ *   VOTES_OUT_OF_MEMORY if the map had to grow and the allocation failed
+ *   VOTES_SUCCESS otherwise
+ */
+VotesResult votesChange(Votes votes, int taker, int difference);
+
+/***
+ * Remove all the votes given to a state
+ * @param votes - The votes row
+ * @param taker - ID of the state that receives the votes
+ * @return true if the state had votes in the row, false otherwise
+ */
+bool votesRemove(Votes votes, int taker);
+
+#endif //VOTES_H